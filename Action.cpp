@@ -1,25 +1,76 @@
 #include "Action.hpp"
 
-#include <sstream>
+#include <vector>
+
+namespace
+{
+	// indexed by ActionId, in the order of the ActionName constants
+	std::vector<std::string>& actionNames()
+	{
+		static std::vector<std::string> names =
+		{
+			"NONE", "UP", "DOWN", "PLAY", "QUIT", "PAUSE",
+			"TOGGLE_TEXTURE", "TOGGLE_COLLISION", "TOGGLE_GRID",
+			"JUMP", "LEFT", "RIGHT", "SHOOT"
+		};
+		return names;
+	}
+}
 
 Action::Action()
 {
 
 }
 
-Action::Action(const std::string& name, const std::string& type)
+Action::Action(ActionId name, ActionType type)
 	: m_name(name)
 	, m_type(type)
 {
 
 }
 
-const std::string& Action::name() const
+Action::Action(const std::string& name, const std::string& type)
+	: m_name(registerName(name))
+	, m_type(typeOf(type))
+{
+
+}
+
+ActionId Action::id() const
 {
 	return m_name;
 }
 
-const std::string& Action::type() const
+ActionType Action::type() const
 {
 	return m_type;
+}
+
+const std::string& Action::name() const
+{
+	return nameOf(m_name);
+}
+
+ActionId Action::registerName(const std::string& name)
+{
+	auto& names = actionNames();
+	for (ActionId id = 0; id < names.size(); id++)
+	{
+		if (names[id] == name) { return id; }
+	}
+
+	names.push_back(name);
+	return (ActionId)(names.size() - 1);
+}
+
+const std::string& Action::nameOf(ActionId id)
+{
+	return actionNames()[id];
+}
+
+ActionType Action::typeOf(const std::string& type)
+{
+	if (type == "START")	{ return ActionType::Start; }
+	if (type == "END")		{ return ActionType::End; }
+	return ActionType::None;
 }
\ No newline at end of file
@@ -2,19 +2,61 @@
 
 #include "Entity.hpp"
 
+#include <cstdint>
 #include <string>
 
+// action names are small integers interned once, so sending an action copies no strings
+// the actions the game uses are fixed compile-time constants, others can be
+// registered by name at runtime and are numbered after ActionName::BuiltinCount
+typedef std::uint16_t ActionId;
+
+namespace ActionName
+{
+	enum : ActionId
+	{
+		None,
+		Up,
+		Down,
+		Play,
+		Quit,
+		Pause,
+		ToggleTexture,
+		ToggleCollision,
+		ToggleGrid,
+		Jump,
+		Left,
+		Right,
+		Shoot,
+		BuiltinCount
+	};
+}
+
+enum class ActionType : std::uint8_t
+{
+	None,
+	Start,
+	End
+};
+
 class Action
 {
-	std::string m_name = "NONE";
-	std::string m_type = "NONE";
+	ActionId	m_name = ActionName::None;
+	ActionType	m_type = ActionType::None;
 
 public:
 
 	Action();
+	Action(ActionId name, ActionType type);
+
+	// interns the name, for scripts and tools; the "START" and "END" types are the only ones recognized
 	Action(const std::string& name, const std::string& type);
 
+	ActionId id() const;
+	ActionType type() const;
 	const std::string& name() const;
-	const std::string& type() const;
-	//std::string toString() const;
+
+	// the name table is shared by every scene and is only changed from the main thread
+	static ActionId registerName(const std::string& name);
+	static const std::string& nameOf(ActionId id);
+	static ActionType typeOf(const std::string& type);
 };
\ No newline at end of file
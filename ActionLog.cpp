@@ -0,0 +1,197 @@
+#include "ActionLog.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace
+{
+	// recording layout: FileHeader, FileString names[nameCount], FileEntry entries[entryCount], char strings[stringBytes]
+	const char		LogMagic[4] = { 'M', 'R', 'E', 'C' };
+	const uint32_t	LogVersion = 1;
+
+	struct FileHeader
+	{
+		char		magic[4];
+		uint32_t	version;
+		uint32_t	nameCount;
+		uint32_t	entryCount;
+		uint32_t	stringBytes;
+		uint32_t	endScene, endFrame;
+	};
+
+	struct FileString
+	{
+		uint32_t	offset, length;			// into the string section
+	};
+
+	struct FileEntry
+	{
+		uint32_t	frame;
+		uint16_t	scene;
+		uint8_t		name;
+		uint8_t		start;
+	};
+
+	static_assert(sizeof(FileHeader) == 28 && sizeof(FileString) == 8 && sizeof(FileEntry) == 8,
+		"recording structs must not be padded");
+}
+
+bool ActionLog::Position::operator == (const Position& rhs) const
+{
+	return scene == rhs.scene && frame == rhs.frame;
+}
+
+bool ActionLog::Position::operator < (const Position& rhs) const
+{
+	return scene < rhs.scene || (scene == rhs.scene && frame < rhs.frame);
+}
+
+ActionLog::ActionLog()
+{
+
+}
+
+void ActionLog::clear()
+{
+	m_actions.clear();
+	m_entries.clear();
+	m_end = Position();
+}
+
+void ActionLog::record(const Position& at, const Action& action)
+{
+	auto name = std::find(m_actions.begin(), m_actions.end(), action.id());
+	if (name == m_actions.end())
+	{
+		m_actions.push_back(action.id());
+		name = m_actions.end() - 1;
+	}
+
+	Entry entry;
+	entry.at = at;
+	entry.name = (uint16_t)(name - m_actions.begin());
+	entry.start = action.type() == ActionType::Start;
+	m_entries.push_back(entry);
+	m_end = at;
+}
+
+void ActionLog::finish(const Position& end)
+{
+	m_end = end;
+}
+
+bool ActionLog::save(const std::string& path) const
+{
+	if (m_actions.size() > 256 || m_end.scene > 0xFFFF)
+	{
+		std::cerr << "Recording has too many action names or scene changes to be saved: " << path << std::endl;
+		return false;
+	}
+
+	std::vector<FileString> names;
+	std::string strings;
+	for (ActionId id : m_actions)
+	{
+		const std::string& name = Action::nameOf(id);
+		names.push_back({ (uint32_t)strings.size(), (uint32_t)name.size() });
+		strings += name;
+	}
+
+	std::vector<FileEntry> entries;
+	for (auto& e : m_entries)
+	{
+		entries.push_back({ e.at.frame, (uint16_t)e.at.scene, (uint8_t)e.name, (uint8_t)e.start });
+	}
+
+	FileHeader header;
+	std::memcpy(header.magic, LogMagic, 4);
+	header.version = LogVersion;
+	header.nameCount = (uint32_t)names.size();
+	header.entryCount = (uint32_t)entries.size();
+	header.stringBytes = (uint32_t)strings.size();
+	header.endScene = m_end.scene;
+	header.endFrame = m_end.frame;
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) { return false; }
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(names.data()), names.size() * sizeof(FileString));
+	file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(FileEntry));
+	file.write(strings.data(), strings.size());
+	return file.good();
+}
+
+bool ActionLog::load(const std::string& path)
+{
+	clear();
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file) { return false; }
+	std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	FileHeader header;
+	if (data.size() < sizeof(header)) { return false; }
+	std::memcpy(&header, data.data(), sizeof(header));
+
+	const size_t expected = sizeof(FileHeader) + header.nameCount * sizeof(FileString) + header.entryCount * sizeof(FileEntry) + header.stringBytes;
+	if (std::memcmp(header.magic, LogMagic, 4) != 0 || header.version != LogVersion || data.size() != expected)
+	{
+		std::cerr << "Not a recording (version " << LogVersion << "): " << path << std::endl;
+		return false;
+	}
+
+	std::vector<FileString> names(header.nameCount);
+	std::vector<FileEntry> entries(header.entryCount);
+	size_t offset = sizeof(FileHeader);
+	std::memcpy(names.data(), data.data() + offset, names.size() * sizeof(FileString));
+	offset += names.size() * sizeof(FileString);
+	std::memcpy(entries.data(), data.data() + offset, entries.size() * sizeof(FileEntry));
+	offset += entries.size() * sizeof(FileEntry);
+
+	for (auto& name : names)
+	{
+		if ((size_t)name.offset + name.length > header.stringBytes) { clear(); return false; }
+		m_actions.push_back(Action::registerName(data.substr(offset + name.offset, name.length)));
+	}
+
+	for (auto& e : entries)
+	{
+		if (e.name >= m_actions.size()) { clear(); return false; }
+
+		Entry entry;
+		entry.at.scene = e.scene;
+		entry.at.frame = e.frame;
+		entry.name = e.name;
+		entry.start = e.start != 0;
+		m_entries.push_back(entry);
+	}
+
+	m_end.scene = header.endScene;
+	m_end.frame = header.endFrame;
+	return true;
+}
+
+size_t ActionLog::size() const
+{
+	return m_entries.size();
+}
+
+const ActionLog::Entry& ActionLog::entry(size_t index) const
+{
+	return m_entries[index];
+}
+
+Action ActionLog::action(size_t index) const
+{
+	const Entry& e = m_entries[index];
+	return Action(m_actions[e.name], e.start ? ActionType::Start : ActionType::End);
+}
+
+const ActionLog::Position& ActionLog::end() const
+{
+	return m_end;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Action.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// the actions a session sent to its scenes, each with the simulation step it arrived at
+// replaying them in a fresh engine at the same steps gives the same game, since the scenes only
+// read input through doAction and always run in fixed steps
+class ActionLog
+{
+public:
+
+	// when an action arrived: the number of scene changes so far and the frame of the scene it went to
+	struct Position
+	{
+		uint32_t		scene = 0;
+		uint32_t		frame = 0;
+
+		bool operator == (const Position& rhs) const;
+		bool operator < (const Position& rhs) const;
+	};
+
+	struct Entry
+	{
+		Position		at;
+		uint16_t		name = 0;				// index into the action table
+		bool			start = true;			// START, or END if false
+	};
+
+private:
+
+	std::vector<ActionId>		m_actions;		// the actions seen, their names are what the file stores
+	std::vector<Entry>			m_entries;
+	Position					m_end;			// where the recorded session stopped
+
+public:
+
+	ActionLog();
+
+	void clear();
+	void record(const Position& at, const Action& action);
+	void finish(const Position& end);
+
+	// the recording format is binary, 8 bytes per action plus the action names
+	bool save(const std::string& path) const;
+	bool load(const std::string& path);
+
+	size_t size() const;
+	const Entry& entry(size_t index) const;
+	Action action(size_t index) const;
+	const Position& end() const;
+};
\ No newline at end of file
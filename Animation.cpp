@@ -12,15 +12,30 @@ Animation::Animation(const std::string& name, const sf::Texture& t)
 }
 
 Animation::Animation(const std::string& name, const sf::Texture& t, size_t frameCount, size_t speed)
+	: Animation(name, t, sf::IntRect(0, 0, t.getSize().x, t.getSize().y), frameCount, speed)
+{
+
+}
+
+// the frames are laid out left to right inside region, which is usually an atlas sub-rectangle
+Animation::Animation(const std::string& name, const sf::Texture& t, const sf::IntRect& region, size_t frameCount, size_t speed)
+	: Animation(name, region, frameCount, speed)
+{
+	m_sprite.setTexture(t);
+}
+
+// builds the animation from the region alone, the sprite is left without a
+// texture so this is usable by a headless engine with no GL context
+Animation::Animation(const std::string& name, const sf::IntRect& region, size_t frameCount, size_t speed)
 	: m_name(name)
-	, m_sprite(t)
 	, m_frameCount(frameCount)
 	, m_currentFrame(0)
 	, m_speed(speed)
+	, m_offset(region.left, region.top)
 {
-	m_size = Vec2((float)t.getSize().x / frameCount, (float)t.getSize().y);
+	m_size = Vec2((float)region.width / frameCount, (float)region.height);
 	m_sprite.setOrigin(m_size.x / 2.0f, m_size.y / 2.0f);
-	m_sprite.setTextureRect(sf::IntRect(std::floor(m_currentFrame) * m_size.x, 0, m_size.x, m_size.y));
+	m_sprite.setTextureRect(sf::IntRect(m_offset.x + std::floor(m_currentFrame) * m_size.x, m_offset.y, m_size.x, m_size.y));
 }
 
 // updates the animation to show the next frame, depending on its speed
@@ -34,7 +49,7 @@ void Animation::update()
 	//		 2) set the texture rectangle properly (see constructor for sample)
 	if (m_speed != 0)
 	{
-		m_sprite.setTextureRect(sf::IntRect(std::floor((m_currentFrame / m_speed) % m_frameCount) * m_size.x, 0, m_size.x, m_size.y));
+		m_sprite.setTextureRect(sf::IntRect(m_offset.x + std::floor((m_currentFrame / m_speed) % m_frameCount) * m_size.x, m_offset.y, m_size.x, m_size.y));
 	}
 }
 
@@ -53,6 +68,11 @@ sf::Sprite& Animation::getSprite()
 	return m_sprite;
 }
 
+const sf::Sprite& Animation::getSprite() const
+{
+	return m_sprite;
+}
+
 bool Animation::hasEnded() const
 {
 	// TODO: detect when animation has ended (last frame was played) and return true
@@ -12,6 +12,7 @@ class Animation
 	size_t		m_currentFrame	= 0; // the current frame of animation being played
 	size_t		m_speed			= 0; // the speed to play this animation
 	Vec2		m_size			= { 1, 1 }; // size of the animation frame
+	sf::Vector2i m_offset		= { 0, 0 }; // top-left of the first frame inside the (atlas) texture
 	std::string	m_name = "none";
 
 public:
@@ -19,10 +20,13 @@ public:
 	Animation();
 	Animation(const std::string& name, const sf::Texture& t);
 	Animation(const std::string& name, const sf::Texture& t, size_t frameCount, size_t speed);
+	Animation(const std::string& name, const sf::Texture& t, const sf::IntRect& region, size_t frameCount, size_t speed);
+	Animation(const std::string& name, const sf::IntRect& region, size_t frameCount, size_t speed);
 
 	void update();
 	bool hasEnded() const;
 	const std::string& getName() const;
 	const Vec2& getSize() const;
 	sf::Sprite& getSprite();
+	const sf::Sprite& getSprite() const;
 };
\ No newline at end of file
@@ -1,15 +1,140 @@
 #include "Assets.hpp"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 Assets::Assets()
 {
 
 }
 
-void Assets::loadFromFile(const std::string& path)
+namespace
 {
+	// asset pack layout, flat arrays after the header followed by the raw data:
+	// PackHeader, PackSource sources[sourceCount], PackPage pages[pageCount], PackRegion regions[regionCount],
+	// PackAnimation animations[animationCount], PackFont fonts[fontCount], char strings[stringBytes],
+	// then the RGBA pixels of every atlas page and the font files, located by their offsets into that data
+	const char		PackMagic[4] = { 'M', 'P', 'A', 'K' };
+	const uint32_t	PackVersion = 2;
+
+	struct PackHeader
+	{
+		char		magic[4];
+		uint32_t	version;
+		uint64_t	listHash;			// hash of the assets.txt the pack was built from
+		uint32_t	sourceCount, pageCount, regionCount, animationCount, fontCount, stringBytes;
+		uint64_t	dataBytes;
+	};
+
+	struct PackString
+	{
+		uint32_t	offset, length;		// into the string section
+	};
+
+	// a loose file the pack was built from, the pack is stale once one of them changes
+	struct PackSource
+	{
+		PackString	path;
+		uint64_t	size;
+		int64_t		mtime;
+	};
+
+	struct PackPage
+	{
+		uint32_t	width, height, offset;
+	};
+
+	struct PackRegion
+	{
+		PackString	name;
+		uint32_t	page;
+		int32_t		left, top, width, height;
+	};
+
+	struct PackAnimation
+	{
+		PackString	name, texture;
+		uint32_t	frames, speed;
+	};
+
+	struct PackFont
+	{
+		PackString	name;
+		uint32_t	offset, size;
+	};
+
+	static_assert(sizeof(PackHeader) == 48 && sizeof(PackSource) == 24 && sizeof(PackPage) == 12 &&
+		sizeof(PackRegion) == 28 && sizeof(PackAnimation) == 24 && sizeof(PackFont) == 16, "asset pack structs must not be padded");
+
+	bool readFile(const std::string& path, std::string& out)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file) { return false; }
+
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+		out = buffer.str();
+		return true;
+	}
+
+	uint64_t hashBytes(const std::string& bytes)
+	{
+		// 64 bit FNV-1a
+		uint64_t hash = 14695981039346656037ull;
+		for (unsigned char c : bytes)
+		{
+			hash = (hash ^ c) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	bool fileStamp(const std::string& path, uint64_t& size, int64_t& mtime)
+	{
+		std::error_code error;
+		size = std::filesystem::file_size(path, error);
+		if (error) { return false; }
+
+		mtime = (int64_t)std::filesystem::last_write_time(path, error).time_since_epoch().count();
+		return !error;
+	}
+
+	template <typename T>
+	const T* section(const char* data, size_t& offset, size_t count)
+	{
+		const T* p = reinterpret_cast<const T*>(data + offset);
+		offset += count * sizeof(T);
+		return p;
+	}
+}
+
+void Assets::loadFromFile(const std::string& path, bool headless)
+{
+	m_headless = headless;
+	sf::Clock clock;
+
+	if (loadFromPack(packPath(path), path))
+	{
+		std::cout << "Loaded asset pack " << packPath(path) << " in " << clock.getElapsedTime().asSeconds() * 1000 << "ms" << std::endl;
+		return;
+	}
+
+	loadLooseFiles(path);
+}
+
+Assets::AssetList Assets::readAssetList(const std::string& path)
+{
+	AssetList list;
+
 	std::ifstream file(path);
 	std::string str;
 	while (file.good())
@@ -18,55 +143,350 @@ void Assets::loadFromFile(const std::string& path)
 
 		if (str == "Texture")
 		{
-			std::string name, path;
-			file >> name >> path;
-			addTexture(name, path);
+			TextureEntry entry;
+			file >> entry.name >> entry.path;
+			list.textures.push_back(entry);
 		}
 		else if (str == "Animation")
 		{
-			std::string name, texture;
-			size_t frames, speed;
-			file >> name >> texture >> frames >> speed;
-			addAnimation(name, texture, frames, speed);
+			AnimationEntry entry;
+			file >> entry.name >> entry.texture >> entry.frames >> entry.speed;
+			list.animations.push_back(entry);
 		}
 		else if (str == "Font")
 		{
-			std::string name, path;
-			file >> name >> path;
-			addFont(name, path);
+			FontEntry entry;
+			file >> entry.name >> entry.path;
+			list.fonts.push_back(entry);
 		}
 		else
 		{
 			std::cerr << "Unknown Asset Type " << str << std::endl;
 		}
 	}
+
+	return list;
 }
 
-void Assets::addTexture(const std::string& textureName, const std::string& path, bool smooth)
+size_t Assets::decodeImages(std::vector<TextureEntry>& textures, const std::function<void()>& whileDecoding)
 {
-	m_textureMap[textureName] = sf::Texture();
+	// each worker decodes the next image nobody has claimed yet, until there are none left
+	std::atomic<size_t> nextTexture(0);
+	size_t threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), textures.size());
+	std::vector<std::future<void>> workers;
+	for (size_t t = 0; t < threadCount; t++)
+	{
+		workers.push_back(std::async(std::launch::async, [&]()
+		{
+			for (size_t i = nextTexture++; i < textures.size(); i = nextTexture++)
+			{
+				textures[i].loaded = textures[i].image.loadFromFile(textures[i].path);
+			}
+		}));
+	}
+
+	if (whileDecoding) { whileDecoding(); }
 
-	if (!m_textureMap[textureName].loadFromFile(path))
+	for (auto& worker : workers)
 	{
-		std::cerr << "Cound not load texture file: " << path << std::endl;
-		m_textureMap.erase(textureName);
+		worker.get();
 	}
-	else
+
+	return threadCount;
+}
+
+void Assets::loadLooseFiles(const std::string& path)
+{
+	sf::Clock clock;
+
+	// images are decoded on worker threads, and animations point into the texture atlas,
+	// which can only be packed once every texture is known, so the file is read up front
+	AssetList list = readAssetList(path);
+
+	// fonts are loaded on the main thread while the images decode
+	size_t threadCount = decodeImages(list.textures, [&]()
 	{
-		m_textureMap[textureName].setSmooth(smooth);
-		std::cout << "Loaded Texture: " << path << std::endl;
+		for (auto& f : list.fonts)
+		{
+			addFont(f.name, f.path);
+		}
+	});
+	const float decodeTime = clock.getElapsedTime().asSeconds();
+
+	// textures go into the atlas in file order, so the packing does not depend on which thread finished first
+	for (auto& t : list.textures)
+	{
+		addTexture(t.name, t.path, t.image, t.loaded);
 	}
+
+	// a headless engine has no GL context, it only needs the packed rectangles
+	m_atlas.build(!m_headless, true);
+	std::cout << "Packed textures into " << m_atlas.pageCount() << " atlas page(s)" << std::endl;
+
+	for (auto& a : list.animations)
+	{
+		addAnimation(a.name, a.texture, a.frames, a.speed);
+	}
+
+	std::cout << "Loaded " << list.textures.size() << " textures on " << threadCount << " thread(s) in " << decodeTime * 1000
+		<< "ms, assets ready after " << clock.getElapsedTime().asSeconds() * 1000 << "ms" << std::endl;
+}
+
+bool Assets::loadFromPack(const std::string& packPath, const std::string& path)
+{
+	if (!m_pack.open(packPath)) { return false; }
+
+	const char* data = m_pack.data();
+	const PackHeader* header = reinterpret_cast<const PackHeader*>(data);
+	if (m_pack.size() < sizeof(PackHeader) || std::memcmp(header->magic, PackMagic, 4) != 0 || header->version != PackVersion)
+	{
+		std::cerr << "Not an asset pack (version " << PackVersion << "): " << packPath << std::endl;
+		m_pack.close();
+		return false;
+	}
+
+	size_t offset = sizeof(PackHeader);
+	const PackSource* sources = section<PackSource>(data, offset, header->sourceCount);
+	const PackPage* pages = section<PackPage>(data, offset, header->pageCount);
+	const PackRegion* regions = section<PackRegion>(data, offset, header->regionCount);
+	const PackAnimation* animations = section<PackAnimation>(data, offset, header->animationCount);
+	const PackFont* fonts = section<PackFont>(data, offset, header->fontCount);
+	const char* strings = section<char>(data, offset, header->stringBytes);
+	const char* blobs = data + offset;
+	if (header->dataBytes > m_pack.size() || offset + header->dataBytes != m_pack.size())
+	{
+		std::cerr << "Asset pack is truncated: " << packPath << std::endl;
+		m_pack.close();
+		return false;
+	}
+
+	auto string = [&](const PackString& s) { return std::string(strings + s.offset, s.length); };
+
+	// every offset and index is checked before anything is loaded, so a damaged pack falls back to the loose files whole
+	auto inStrings = [&](const PackString& s) { return (size_t)s.offset + s.length <= header->stringBytes; };
+	auto inBlobs = [&](uint64_t blobOffset, uint64_t size) { return blobOffset <= header->dataBytes && size <= header->dataBytes - blobOffset; };
+
+	bool valid = std::all_of(sources, sources + header->sourceCount, [&](const PackSource& p) { return inStrings(p.path); }) &&
+		std::all_of(pages, pages + header->pageCount, [&](const PackPage& p) { return inBlobs(p.offset, (uint64_t)p.width * p.height * 4); }) &&
+		std::all_of(fonts, fonts + header->fontCount, [&](const PackFont& f) { return inStrings(f.name) && inBlobs(f.offset, f.size); });
+
+	std::set<std::string> regionNames;
+	for (uint32_t i = 0; i < header->regionCount && valid; i++)
+	{
+		const PackRegion& r = regions[i];
+		valid = inStrings(r.name) && r.page < header->pageCount && r.left >= 0 && r.top >= 0 && r.width >= 0 && r.height >= 0 &&
+			(int64_t)r.left + r.width <= pages[r.page].width && (int64_t)r.top + r.height <= pages[r.page].height;
+		if (valid) { regionNames.insert(string(r.name)); }
+	}
+	for (uint32_t i = 0; i < header->animationCount && valid; i++)
+	{
+		const PackAnimation& a = animations[i];
+		valid = inStrings(a.name) && inStrings(a.texture) && a.frames > 0 && regionNames.count(string(a.texture)) > 0;
+	}
+	if (!valid)
+	{
+		std::cerr << "Asset pack is corrupt, rebuild it with --pack: " << packPath << std::endl;
+		m_pack.close();
+		return false;
+	}
+
+	// the pack is stale if assets.txt or any file it names changed since it was built
+	// loose files that are not there at all are fine, the pack can be shipped on its own
+	std::string list;
+	bool stale = readFile(path, list) && hashBytes(list) != header->listHash;
+	for (uint32_t i = 0; i < header->sourceCount && !stale; i++)
+	{
+		uint64_t size;
+		int64_t mtime;
+		stale = fileStamp(string(sources[i].path), size, mtime) && (size != sources[i].size || mtime != sources[i].mtime);
+	}
+	if (stale)
+	{
+		std::cerr << "Ignoring stale asset pack " << packPath << ", rebuild it with --pack" << std::endl;
+		m_pack.close();
+		return false;
+	}
+
+	// the page textures are uploaded straight from the mapped pixels
+	for (uint32_t i = 0; i < header->regionCount; i++)
+	{
+		TextureAtlas::Region region;
+		region.page = regions[i].page;
+		region.rect = sf::IntRect(regions[i].left, regions[i].top, regions[i].width, regions[i].height);
+		m_atlas.addRegion(string(regions[i].name), region);
+	}
+
+	std::vector<sf::Vector2u> pageSizes;
+	std::vector<const sf::Uint8*> pagePixels;
+	for (uint32_t i = 0; i < header->pageCount; i++)
+	{
+		pageSizes.push_back(sf::Vector2u(pages[i].width, pages[i].height));
+		pagePixels.push_back(reinterpret_cast<const sf::Uint8*>(blobs + pages[i].offset));
+	}
+	m_atlas.setPages(pageSizes, pagePixels, !m_headless, true);
+
+	// fonts read from memory keep pointing into the mapping, which stays open for the lifetime of the assets
+	for (uint32_t i = 0; i < header->fontCount; i++)
+	{
+		const std::string name = string(fonts[i].name);
+		if (!m_fontMap[name].loadFromMemory(blobs + fonts[i].offset, fonts[i].size))
+		{
+			std::cerr << "Cound not load font " << name << " from the asset pack" << std::endl;
+			m_fontMap.erase(name);
+		}
+	}
+
+	for (uint32_t i = 0; i < header->animationCount; i++)
+	{
+		addAnimation(string(animations[i].name), string(animations[i].texture), animations[i].frames, animations[i].speed);
+	}
+
+	return true;
+}
+
+bool Assets::buildPack(const std::string& path, const std::string& packPath)
+{
+	std::string listText;
+	if (!readFile(path, listText))
+	{
+		std::cerr << "Could not read asset list: " << path << std::endl;
+		return false;
+	}
+
+	AssetList list = readAssetList(path);
+	decodeImages(list.textures, nullptr);
+
+	std::vector<PackSource> sources;
+	std::vector<PackPage> pages;
+	std::vector<PackRegion> regions;
+	std::vector<PackAnimation> animations;
+	std::vector<PackFont> fonts;
+	std::string strings, blobs;
+
+	auto addString = [&](const std::string& s)
+	{
+		PackString str = { (uint32_t)strings.size(), (uint32_t)s.size() };
+		strings += s;
+		return str;
+	};
+	auto addSource = [&](const std::string& sourcePath)
+	{
+		PackSource source = { addString(sourcePath), 0, 0 };
+		fileStamp(sourcePath, source.size, source.mtime);
+		sources.push_back(source);
+	};
+
+	// pack the atlas exactly as a loose load would, and keep the composed pages
+	TextureAtlas atlas;
+	for (auto& t : list.textures)
+	{
+		if (!t.loaded)
+		{
+			std::cerr << "Cound not load texture file: " << t.path << std::endl;
+			return false;
+		}
+		atlas.add(t.name, t.image);
+		addSource(t.path);
+	}
+
+	std::vector<sf::Image> pageImages;
+	atlas.build(false, true, &pageImages);
+	for (auto& image : pageImages)
+	{
+		pages.push_back({ image.getSize().x, image.getSize().y, (uint32_t)blobs.size() });
+		blobs.append(reinterpret_cast<const char*>(image.getPixelsPtr()), (size_t)image.getSize().x * image.getSize().y * 4);
+	}
+
+	for (auto& [name, region] : atlas.regions())
+	{
+		regions.push_back({ addString(name), (uint32_t)region.page, region.rect.left, region.rect.top, region.rect.width, region.rect.height });
+	}
+
+	for (auto& a : list.animations)
+	{
+		animations.push_back({ addString(a.name), addString(a.texture), (uint32_t)a.frames, (uint32_t)a.speed });
+	}
+
+	for (auto& f : list.fonts)
+	{
+		std::string font;
+		if (!readFile(f.path, font))
+		{
+			std::cerr << "Cound not load font file: " << f.path << std::endl;
+			return false;
+		}
+		fonts.push_back({ addString(f.name), (uint32_t)blobs.size(), (uint32_t)font.size() });
+		blobs += font;
+		addSource(f.path);
+	}
+
+	PackHeader header;
+	std::memcpy(header.magic, PackMagic, 4);
+	header.version = PackVersion;
+	header.listHash = hashBytes(listText);
+	header.sourceCount = (uint32_t)sources.size();
+	header.pageCount = (uint32_t)pages.size();
+	header.regionCount = (uint32_t)regions.size();
+	header.animationCount = (uint32_t)animations.size();
+	header.fontCount = (uint32_t)fonts.size();
+	header.stringBytes = (uint32_t)strings.size();
+	header.dataBytes = blobs.size();
+
+	std::ofstream file(packPath, std::ios::binary | std::ios::trunc);
+	if (!file) { return false; }
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(sources.data()), sources.size() * sizeof(PackSource));
+	file.write(reinterpret_cast<const char*>(pages.data()), pages.size() * sizeof(PackPage));
+	file.write(reinterpret_cast<const char*>(regions.data()), regions.size() * sizeof(PackRegion));
+	file.write(reinterpret_cast<const char*>(animations.data()), animations.size() * sizeof(PackAnimation));
+	file.write(reinterpret_cast<const char*>(fonts.data()), fonts.size() * sizeof(PackFont));
+	file.write(strings.data(), strings.size());
+	file.write(blobs.data(), blobs.size());
+	return file.good();
+}
+
+std::string Assets::packPath(const std::string& path)
+{
+	return std::filesystem::path(path).replace_extension(".pak").string();
+}
+
+void Assets::addTexture(const std::string& textureName, const std::string& path, const sf::Image& image, bool loaded)
+{
+	// textures are decoded on the CPU and handed to the atlas, which uploads
+	// whole pages at once (and never touches the GPU when running headless)
+	// every page is smooth, which is the default for every texture in assets.txt
+	if (!loaded)
+	{
+		std::cerr << "Cound not load texture file: " << path << std::endl;
+		return;
+	}
+
+	m_atlas.add(textureName, image);
+	std::cout << "Loaded Texture: " << path << std::endl;
 }
 
 const sf::Texture& Assets::getTexture(const std::string& textureName) const
 {
-	assert(m_textureMap.find(textureName) != m_textureMap.end());
-	return m_textureMap.at(textureName);
+	assert(m_atlas.hasRegion(textureName));
+	return m_atlas.page(m_atlas.region(textureName).page);
+}
+
+const sf::IntRect& Assets::getTextureRect(const std::string& textureName) const
+{
+	assert(m_atlas.hasRegion(textureName));
+	return m_atlas.region(textureName).rect;
 }
 
 void Assets::addAnimation(const std::string& animationName, const std::string& textureName, size_t frameCount, size_t speed)
 {
-	m_animationMap[animationName] = Animation(animationName, getTexture(textureName), frameCount, speed);
+	if (m_headless)
+	{
+		m_animationMap[animationName] = Animation(animationName, getTextureRect(textureName), frameCount, speed);
+		return;
+	}
+
+	m_animationMap[animationName] = Animation(animationName, getTexture(textureName), getTextureRect(textureName), frameCount, speed);
 }
 
 const Animation& Assets::getAnimation(const std::string& animationName) const
@@ -75,6 +495,20 @@ const Animation& Assets::getAnimation(const std::string& animationName) const
 	return m_animationMap.at(animationName);
 }
 
+uint64_t Assets::animationHash() const
+{
+	std::string bytes;
+	for (auto& [name, animation] : m_animationMap)
+	{
+		const Vec2& size = animation.getSize();
+		bytes += name;
+		bytes.push_back('\0');
+		bytes.append(reinterpret_cast<const char*>(&size.x), sizeof(size.x));
+		bytes.append(reinterpret_cast<const char*>(&size.y), sizeof(size.y));
+	}
+	return hashBytes(bytes);
+}
+
 void Assets::addFont(const std::string& fontName, const std::string& path)
 {
 	m_fontMap[fontName] = sf::Font();
@@ -1,14 +1,50 @@
 #pragma once
 
 #include "Animation.hpp"
+#include "TextureAtlas.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <functional>
 
 class Assets
 {
-	std::map<std::string, sf::Texture>		m_textureMap;
+	// the entries of assets.txt, read up front so images can be decoded in parallel
+	struct TextureEntry
+	{
+		std::string name, path;
+		sf::Image image;
+		bool loaded = false;
+	};
+	struct AnimationEntry
+	{
+		std::string name, texture;
+		size_t frames, speed;
+	};
+	struct FontEntry
+	{
+		std::string name, path;
+	};
+	struct AssetList
+	{
+		std::vector<TextureEntry>	textures;
+		std::vector<AnimationEntry>	animations;
+		std::vector<FontEntry>		fonts;
+	};
+
+	TextureAtlas							m_atlas;	// every Texture entry is packed into its pages
 	std::map<std::string, Animation>		m_animationMap;
 	std::map<std::string, sf::Font>			m_fontMap;
+	bool									m_headless = false;
+	MappedFile								m_pack;		// page pixels and font files point into it while open
+
+	static AssetList readAssetList(const std::string& path);
+	static size_t decodeImages(std::vector<TextureEntry>& textures, const std::function<void()>& whileDecoding);
+
+	bool loadFromPack(const std::string& packPath, const std::string& path);
+	void loadLooseFiles(const std::string& path);
 
-	void addTexture(const std::string& textureName, const std::string& path, bool smooth = true);
+	void addTexture(const std::string& textureName, const std::string& path, const sf::Image& image, bool loaded);
 	void addAnimation(const std::string& animationName, const std::string& textureName, size_t frameCount, size_t speed);
 	void addFont(const std::string& fontName, const std::string& path);
 
@@ -16,9 +52,21 @@ public:
 
 	Assets();
 
-	void loadFromFile(const std::string& path);
+	// uses the asset pack next to path when it is up to date, otherwise the loose files
+	void loadFromFile(const std::string& path, bool headless = false);
 
+	// decodes and packs everything path lists into one pack file, see loadFromPack
+	static bool buildPack(const std::string& path, const std::string& packPath);
+
+	// assets.txt -> assets.pak
+	static std::string packPath(const std::string& path);
+
+	// the atlas page holding the texture, and the texture's rectangle inside it
 	const sf::Texture& getTexture(const std::string& textureName) const;
+	const sf::IntRect& getTextureRect(const std::string& textureName) const;
 	const Animation& getAnimation(const std::string& animationName) const;
 	const sf::Font& getFont(const std::string& fontName) const;
+
+	// hash of every animation's name and frame size, changes whenever a sprite or assets.txt changes a size
+	uint64_t animationHash() const;
 };
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "Benchmark.hpp"
+#include "GameEngine.hpp"
+#include "Scene_Play.hpp"
+#include "Physics.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+	double msSince(const std::chrono::steady_clock::time_point& start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+BenchmarkResult runBenchmark(GameEngine& game, const std::string& level, size_t steps)
+{
+	BenchmarkResult result;
+	resetPeakRss();
+
+	auto start = std::chrono::steady_clock::now();
+	auto scene = std::make_shared<Scene_Play>(&game, level);
+	game.changeScene("PLAY", scene);
+	result.loadMs = msSince(start);
+
+	// hold right the whole run, tap jump and shoot as fast as the controls allow
+	scene->doAction(Action(ActionName::Right, ActionType::Start));
+
+	std::vector<double> times;
+	times.reserve(steps);
+	auto runStart = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < steps; i++)
+	{
+		if (i % 45 == 0)	{ scene->doAction(Action(ActionName::Jump, ActionType::Start)); }
+		if (i % 45 == 25)	{ scene->doAction(Action(ActionName::Jump, ActionType::End)); }
+		if (i % 8 == 0)		{ scene->doAction(Action(ActionName::Shoot, ActionType::Start)); }
+		if (i % 8 == 4)		{ scene->doAction(Action(ActionName::Shoot, ActionType::End)); }
+
+		PROFILE_FRAME();
+		auto stepStart = std::chrono::steady_clock::now();
+		scene->simulate(1);
+		times.push_back(msSince(stepStart));
+	}
+	double total = msSince(runStart);
+
+	if (!times.empty())
+	{
+		std::sort(times.begin(), times.end());
+		auto percentile = [&](double p) { return times[(size_t)(p * (times.size() - 1))]; };
+		result.stepsPerSecond = total > 0 ? steps / (total / 1000.0) : 0;
+		result.p50Ms = percentile(0.50);
+		result.p95Ms = percentile(0.95);
+		result.p99Ms = percentile(0.99);
+		result.maxMs = times.back();
+	}
+
+	result.peakRssKb = peakRssKb();
+
+	// back to the menu, which frees the level before the next run loads
+	game.changeScene("MENU", nullptr, true);
+	return result;
+}
+
+OverlapBenchmarkResult runOverlapBenchmark(size_t boxes, size_t repeats)
+{
+	OverlapBenchmarkResult result;
+
+	// boxes the size of tiles and bullets within a few tiles of the query, about a third of them overlap it
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> offset(-150.0f, 150.0f);
+	std::uniform_real_distribution<float> half(8.0f, 64.0f);
+
+	const Vec2 pos(500, 400), halfSize(24, 24);
+	std::vector<Vec2> positions, halfSizes;
+	Physics::Boxes soa;
+	for (size_t i = 0; i < boxes; i++)
+	{
+		positions.push_back(Vec2(pos.x + offset(rng), pos.y + offset(rng)));
+		halfSizes.push_back(Vec2(half(rng), half(rng)));
+		soa.push_back(positions.back(), halfSizes.back());
+	}
+
+	// the per-pair loop stores its results too, so neither side can skip any work
+	std::vector<Vec2> pairOverlaps(boxes);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < repeats; r++)
+	{
+		for (size_t i = 0; i < boxes; i++)
+		{
+			pairOverlaps[i] = Physics::GetOverlap(positions[i], halfSizes[i], pos, halfSize);
+		}
+	}
+	result.pairNs = msSince(start) * 1000000.0 / (double)(boxes * repeats);
+
+	Physics::Overlaps overlaps;
+	start = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < repeats; r++)
+	{
+		Physics::GetOverlaps(pos, halfSize, soa, overlaps);
+	}
+	result.batchNs = msSince(start) * 1000000.0 / (double)(boxes * repeats);
+
+	for (size_t i = 0; i < boxes; i++)
+	{
+		const Vec2& pair = pairOverlaps[i];
+		bool pairHit = pair.x > 0 && pair.y > 0;
+		result.hits += pairHit;
+		if (std::memcmp(&pair.x, &overlaps.x[i], sizeof(float)) != 0 || std::memcmp(&pair.y, &overlaps.y[i], sizeof(float)) != 0
+			|| pairHit != overlaps.hit(i))
+		{
+			result.identical = false;
+		}
+	}
+
+	return result;
+}
+
+#ifdef _WIN32
+
+size_t peakRssKb()
+{
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) { return 0; }
+	return counters.PeakWorkingSetSize / 1024;
+}
+
+void resetPeakRss()
+{
+
+}
+
+#else
+
+size_t peakRssKb()
+{
+	// VmHWM can be reset, ru_maxrss is the peak over the whole process
+	std::ifstream status("/proc/self/status");
+	std::string key;
+	size_t kb;
+	while (status >> key)
+	{
+		if (key == "VmHWM:" && status >> kb) { return kb; }
+	}
+
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0; }
+#ifdef __APPLE__
+	return usage.ru_maxrss / 1024;		// bytes on macOS
+#else
+	return usage.ru_maxrss;
+#endif
+}
+
+void resetPeakRss()
+{
+	// writing 5 to clear_refs resets VmHWM to the current resident size (Linux 4.0+), elsewhere the peak keeps growing
+	std::ofstream clearRefs("/proc/self/clear_refs");
+	if (clearRefs) { clearRefs << "5"; }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+
+class GameEngine;
+
+// end to end throughput of the play scene on one level: the level is loaded into the engine's PLAY
+// scene and simulated headless while a script runs right, jumps and keeps shooting
+// the scene is ended afterwards and the engine is back in the MENU scene
+struct BenchmarkResult
+{
+	double			loadMs = 0;
+	double			stepsPerSecond = 0;
+	double			p50Ms = 0, p95Ms = 0, p99Ms = 0, maxMs = 0;		// per simulation step
+	size_t			peakRssKb = 0;									// 0 where it cannot be measured
+};
+
+BenchmarkResult runBenchmark(GameEngine& game, const std::string& level, size_t steps);
+
+// Physics::GetOverlaps against calling Physics::GetOverlap once per box, on random boxes around the query box
+struct OverlapBenchmarkResult
+{
+	double			pairNs = 0;			// per box
+	double			batchNs = 0;
+	size_t			hits = 0;
+	bool			identical = true;	// both gave bit for bit the same overlaps and hits
+};
+
+OverlapBenchmarkResult runOverlapBenchmark(size_t boxes, size_t repeats);
+
+// the most memory the process has had resident, on Linux since the last resetPeakRss
+// runBenchmark resets it first, so each result is the peak of that run
+size_t peakRssKb();
+void resetPeakRss();
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Components.hpp"
+
+#include <tuple>
+#include <vector>
+
+typedef std::tuple<
+	CTransform,
+	CLifespan,
+	CInput,
+	CBoundingBox,
+	CAnimation,
+	CGravity,
+	CState,
+	CBody
+> ComponentTuple;
+
+// position of a component type in ComponentTuple, e.g. for its bit in a set of component types
+template <typename T, typename Tuple> struct ComponentIndex;
+template <typename T, typename... Ts> struct ComponentIndex<T, std::tuple<T, Ts...>>
+{
+	static const size_t value = 0;
+};
+template <typename T, typename U, typename... Ts> struct ComponentIndex<T, std::tuple<U, Ts...>>
+{
+	static const size_t value = 1 + ComponentIndex<T, std::tuple<Ts...>>::value;
+};
+
+// turns tuple<A, B, ...> into tuple<vector<A>, vector<B>, ...>
+template <typename Tuple> struct ComponentArrays;
+template <typename... Ts> struct ComponentArrays<std::tuple<Ts...>>
+{
+	typedef std::tuple<std::vector<Ts>...> type;
+};
+
+// structure-of-arrays component storage
+// every component type lives in its own contiguous vector and an entity's
+// components all sit at the same slot index, so a system that only needs
+// CTransform streams through the transform array and touches nothing else
+// NOTE: growing the store (adding entities) invalidates component references
+class ComponentStore
+{
+	ComponentArrays<ComponentTuple>::type	m_arrays;
+	size_t									m_size = 0;
+
+	template <size_t I = 0>
+	void resizeArrays(size_t size)
+	{
+		if constexpr (I < std::tuple_size<ComponentTuple>::value)
+		{
+			std::get<I>(m_arrays).resize(size);
+			resizeArrays<I + 1>(size);
+		}
+	}
+
+	template <size_t I = 0>
+	void resetSlot(size_t index)
+	{
+		if constexpr (I < std::tuple_size<ComponentTuple>::value)
+		{
+			auto& array = std::get<I>(m_arrays);
+			array[index] = typename std::decay<decltype(array)>::type::value_type();
+			resetSlot<I + 1>(index);
+		}
+	}
+
+public:
+
+	size_t size() const
+	{
+		return m_size;
+	}
+
+	// adds a slot with default (absent) components and returns its index
+	size_t grow()
+	{
+		resizeArrays(m_size + 1);
+		return m_size++;
+	}
+
+	// marks every component in the slot absent so the slot can be reused
+	void reset(size_t index)
+	{
+		resetSlot(index);
+	}
+
+	template <typename T>
+	std::vector<T>& getArray()
+	{
+		return std::get<std::vector<T>>(m_arrays);
+	}
+
+	template <typename T>
+	const std::vector<T>& getArray() const
+	{
+		return std::get<std::vector<T>>(m_arrays);
+	}
+
+	template <typename T>
+	T& get(size_t index)
+	{
+		return getArray<T>()[index];
+	}
+
+	template <typename T>
+	const T& get(size_t index) const
+	{
+		return getArray<T>()[index];
+	}
+};
\ No newline at end of file
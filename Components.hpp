@@ -2,6 +2,7 @@
 
 #include "Animation.hpp"
 #include "Assets.hpp"
+#include "StateGraph.hpp"
 
 class Component
 {
@@ -50,14 +51,29 @@ public:
 	CInput() {}
 };
 
+// collision layer bits, an entity is only tested against boxes whose layer is in its mask
+namespace CollisionLayer
+{
+	enum : unsigned
+	{
+		None	= 0,
+		Tile	= 1 << 0,
+		Player	= 1 << 1,
+		Bullet	= 1 << 2,
+		All		= ~0u
+	};
+}
+
 class CBoundingBox : public Component
 {
 public:
 	Vec2 size;
 	Vec2 halfSize;
+	unsigned layer	= CollisionLayer::Tile;
+	unsigned mask	= CollisionLayer::All;
 	CBoundingBox() {}
-	CBoundingBox(const Vec2& s)
-		: size(s), halfSize(s.x / 2, s.y / 2) {}
+	CBoundingBox(const Vec2& s, unsigned l = CollisionLayer::Tile, unsigned m = CollisionLayer::All)
+		: size(s), halfSize(s.x / 2, s.y / 2), layer(l), mask(m) {}
 };
 
 class CAnimation : public Component
@@ -81,7 +97,20 @@ public:
 class CState : public Component
 {
 public:
-	std::string state = "jumping";
+	const StateGraph* graph = nullptr;	// shared state machine of this kind of entity
+	size_t state = 0;					// current state in graph
+	bool changed = true;				// the animation system still has to show the new state
 	CState() {}
-	CState(const std::string& s) : state(s) {}
+	CState(const StateGraph& g, size_t s) : graph(&g), state(s) {}
+};
+
+// an entity that moves, static tiles and decorations have none and are never integrated
+// a body that stays at rest falls asleep and is skipped by movement until input or a contact wakes it
+class CBody : public Component
+{
+public:
+	bool asleep = false;
+	size_t restingSteps = 0;			// steps in a row the body ended where it started
+	Vec2 restPos;						// where the body ended the last step
+	CBody() {}
 };
\ No newline at end of file
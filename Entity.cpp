@@ -1,27 +1,53 @@
 #include "Entity.hpp"
 
-Entity::Entity(const size_t& id, const std::string& tag)
-	: m_id(id)
-	, m_tag(tag)
+Entity::Entity()
 {
 }
 
+Entity::Entity(EntityPool* pool, std::uint32_t index, std::uint32_t generation)
+	: m_pool(pool)
+	, m_index(index)
+	, m_generation(generation)
+{
+}
+
+bool Entity::isValid() const
+{
+	return m_pool && m_pool->isValid(m_index, m_generation);
+}
+
 bool Entity::isActive() const
 {
-	return m_active;
+	return isValid() && m_pool->m_active[m_index];
 }
 
-const std::string& Entity::tag() const
+EntityTag Entity::tag() const
 {
-	return m_tag;
+	assert(isValid() && "stale entity handle");
+	return m_pool->m_tags[m_index];
 }
 
 size_t Entity::id() const
 {
-	return m_id;
+	assert(isValid() && "stale entity handle");
+	return m_pool->m_ids[m_index];
+}
+
+size_t Entity::index() const
+{
+	return m_index;
+}
+
+std::uint64_t Entity::handle() const
+{
+	return ((std::uint64_t)m_generation << 32) | m_index;
 }
 
-void Entity::destroy()
+void Entity::destroy() const
 {
-	m_active = false;
+	if (isActive())
+	{
+		m_pool->m_active[m_index] = false;
+		m_pool->m_destroyed.push_back(m_index);
+	}
 }
\ No newline at end of file
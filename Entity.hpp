@@ -1,42 +1,45 @@
 #pragma once
 
-#include "Components.hpp"
+#include "EntityPool.hpp"
 
-#include <tuple>
+#include <cassert>
 #include <string>
 
 class EntityManager;
 
-typedef std::tuple<
-	CTransform,
-	CLifespan,
-	CInput,
-	CBoundingBox,
-	CAnimation,
-	CGravity,
-	CState
-> ComponentTuple;
-
+// a generational handle to an entity slot in an EntityManager's pool
+// handles are cheap to copy (no allocation, no refcount) and a handle whose
+// slot has since been recycled reports isValid() == false instead of
+// silently aliasing the new occupant
 class Entity
 {
 	friend class EntityManager;
 
-	bool			m_active	= true;
-	size_t			m_id		= 0;
-	std::string		m_tag		= "default";
-	ComponentTuple	m_components;
+	EntityPool*		m_pool			= nullptr;
+	std::uint32_t	m_index			= 0;	// slot of this entity in the pool
+	std::uint32_t	m_generation	= 0;	// generation of the slot when this handle was made
 
 	// constructor is private so we can never create
 	// entities outside the EntityManager which had friend access
-	Entity(const size_t& id, const std::string& tag);
+	Entity(EntityPool* pool, std::uint32_t index, std::uint32_t generation);
 
 public:
 
+	// a null handle, refers to no entity
+	Entity();
+
 	//private member access functions
+	bool				isValid()		const;
 	bool				isActive()		const;
-	const std::string&	tag()			const;
+	EntityTag			tag()			const;
 	size_t				id()			const;
-	void				destroy();
+	size_t				index()			const;
+	std::uint64_t		handle()		const;	// generation in the high 32 bits, slot index in the low 32
+	void				destroy()		const;
+
+	explicit operator bool() const { return isValid(); }
+	bool operator == (const Entity& rhs) const { return m_pool == rhs.m_pool && m_index == rhs.m_index && m_generation == rhs.m_generation; }
+	bool operator != (const Entity& rhs) const { return !(*this == rhs); }
 
 	template <typename T>
 	bool hasComponent() const
@@ -45,7 +48,7 @@ public:
 	}
 
 	template <typename T, typename... TArgs>
-	T& addComponent(TArgs&&... mArgs)
+	T& addComponent(TArgs&&... mArgs) const
 	{
 		auto& component = getComponent<T>();
 		component = T(std::forward<TArgs>(mArgs)...);
@@ -53,20 +56,16 @@ public:
 		return component;
 	}
 
+	// a handle behaves like a pointer, a const handle still refers to a mutable entity
 	template<typename T>
-	T& getComponent()
-	{
-		return std::get<T>(m_components);
-	}
-
-	template<typename T>
-	const T& getComponent() const
+	T& getComponent() const
 	{
-		return std::get<T>(m_components);
+		assert(isValid() && "stale entity handle");
+		return m_pool->m_components.get<T>(m_index);
 	}
 
 	template<typename T>
-	void removeComponent()
+	void removeComponent() const
 	{
 		getComponent<T>() = T();
 	}
@@ -1,9 +1,15 @@
 #include "EntityManager.hpp"
 #include <iostream>
+#include <algorithm>
+#include <cassert>
 
 EntityManager::EntityManager()
 {
-
+	// builtin tags are interned in the same order as the Tag constants
+	for (const char* name : { "default", "player", "tile", "dec", "bullet" })
+	{
+		registerTag(name);
+	}
 }
 
 void EntityManager::update()
@@ -15,23 +21,45 @@ void EntityManager::update()
 		m_entities.push_back(e);
 
 		// add it to the entity map in the correct place
-		// map[key] will create an element at "key" if it does not already exist
-		//			therefore we are not in danger of adding to a vector that doesn't exist
-		m_entityMap[e->tag()].push_back(e);
+		// every registered tag already has a vector, so this is a plain index
+		m_entityMap[e.tag()].push_back(e);
 	}
 
 	// clear the temporary vector since we have added everything
 	m_entitiesToAdd.clear();
 
+	// nothing died since the last update, so there is nothing to purge
+	if (m_pool.m_destroyed.empty())
+	{
+		return;
+	}
+
+	// only the tag vectors that actually lost an entity need to be purged
+	for (auto index : m_pool.m_destroyed)
+	{
+		m_tagHasDead[m_pool.m_tags[index]] = true;
+	}
+
 	// remove dead entities from the vector of all entities
 	removeDeadEntities(m_entities);
 
-	// remove dead entities from each vector in the entity map
-	// C++17 way of iterating through [key, value] pairs in a map
-	for (auto& [tag, entityVec] : m_entityMap)
+	// remove dead entities from each tag vector that had a death
+	for (EntityTag tag = 0; tag < m_entityMap.size(); tag++)
 	{
-		removeDeadEntities(entityVec);
+		if (m_tagHasDead[tag])
+		{
+			removeDeadEntities(m_entityMap[tag]);
+			m_tagHasDead[tag] = false;
+		}
+	}
+
+	// return the slots of dead entities to the pool, this bumps their generation
+	// so any handle still pointing at them is now detectably stale
+	for (auto index : m_pool.m_destroyed)
+	{
+		m_pool.release(index);
 	}
+	m_pool.m_destroyed.clear();
 }
 
 void EntityManager::removeDeadEntities(EntityVec& vec)
@@ -40,18 +68,50 @@ void EntityManager::removeDeadEntities(EntityVec& vec)
 	// this is called by the update() function
 
 	const auto newEnd = std::remove_if(vec.begin(), vec.end(),
-		[](const std::shared_ptr<Entity>& i)
+		[](const Entity& i)
 		{
-			return i->isActive() == false;
+			return i.isActive() == false;
 		}
 	);
 
 	vec.erase(newEnd, vec.end());
 }
 
-std::shared_ptr<Entity> EntityManager::addEntity(const std::string& tag)
+EntityTag EntityManager::registerTag(const std::string& name)
 {
-	auto entity = std::shared_ptr<Entity>(new Entity(m_totalEntities++, tag));
+	for (EntityTag tag = 0; tag < m_tagNames.size(); tag++)
+	{
+		if (m_tagNames[tag] == name) { return tag; }
+	}
+
+	m_tagNames.push_back(name);
+	m_entityMap.emplace_back();
+	m_tagHasDead.push_back(false);
+	return m_tagNames.size() - 1;
+}
+
+const std::string& EntityManager::tagName(EntityTag tag) const
+{
+	return m_tagNames[tag];
+}
+
+size_t EntityManager::tagCount() const
+{
+	return m_tagNames.size();
+}
+
+Entity EntityManager::addEntity(const std::string& tag)
+{
+	return addEntity(registerTag(tag));
+}
+
+Entity EntityManager::addEntity(EntityTag tag)
+{
+	assert(tag < m_entityMap.size() && "tag was never registered");
+
+	// no allocation once the pool has warmed up, dead entities' slots are recycled
+	std::uint32_t index = m_pool.allocate(m_totalEntities++, tag);
+	Entity entity(&m_pool, index, m_pool.m_generations[index]);
 
 	m_entitiesToAdd.push_back(entity);
 
@@ -63,7 +123,14 @@ const EntityVec& EntityManager::getEntities()
 	return m_entities;
 }
 
-const EntityVec& EntityManager::getEntities(const std::string& tag)
+const EntityVec& EntityManager::getEntities(EntityTag tag) const
+{
+	// unknown tags have no entities, and looking them up never inserts anything
+	static const EntityVec empty;
+	return (tag < m_entityMap.size()) ? m_entityMap[tag] : empty;
+}
+
+Entity EntityManager::entityAt(size_t index)
 {
-	return m_entityMap[tag];
+	return Entity(&m_pool, (std::uint32_t)index, m_pool.m_generations[index]);
 }
\ No newline at end of file
@@ -2,17 +2,19 @@
 
 #include "Entity.hpp"
 #include <vector>
-#include <map>
 
-typedef std::vector<std::shared_ptr<Entity>> EntityVec;
-typedef std::map<std::string, EntityVec>	 EntityMap;
+typedef std::vector<Entity> EntityVec;
+typedef std::vector<EntityVec>				 EntityMap;	// indexed by EntityTag
 
 class EntityManager
 {
-	EntityVec	m_entities;
-	EntityVec	m_entitiesToAdd;
-	EntityMap	m_entityMap;
-	size_t		m_totalEntities = 0;
+	EntityVec				m_entities;
+	EntityVec				m_entitiesToAdd;
+	EntityMap				m_entityMap;
+	std::vector<std::string>	m_tagNames;		// name of each interned tag, indexed by EntityTag
+	std::vector<char>		m_tagHasDead;	// scratch flags for update(), indexed by EntityTag
+	size_t					m_totalEntities = 0;
+	EntityPool				m_pool;		// entity slots and one contiguous array per component type
 
 	void removeDeadEntities(EntityVec& vec);
 
@@ -22,8 +24,25 @@ public:
 
 	void update();
 
-	std::shared_ptr<Entity> addEntity(const std::string& tag);
+	// interns a tag name, returning the existing id if the name is already known
+	EntityTag registerTag(const std::string& name);
+	const std::string& tagName(EntityTag tag) const;
+	size_t tagCount() const;
+
+	Entity addEntity(EntityTag tag);
+	Entity addEntity(const std::string& tag);
 
 	const EntityVec& getEntities();
-	const EntityVec& getEntities(const std::string& tag);
+	const EntityVec& getEntities(EntityTag tag) const;
+
+	// a handle to the entity in a pool slot, check isActive() since the slot may be free
+	Entity entityAt(size_t index);
+
+	// direct access to the array of one component type for streaming systems
+	// index i belongs to entityAt(i), skip components whose has flag is false
+	template <typename T>
+	std::vector<T>& getComponents()
+	{
+		return m_pool.m_components.getArray<T>();
+	}
 };
\ No newline at end of file
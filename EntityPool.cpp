@@ -0,0 +1,47 @@
+#include "EntityPool.hpp"
+
+EntityPool::EntityPool()
+{
+
+}
+
+std::uint32_t EntityPool::allocate(size_t id, EntityTag tag)
+{
+	std::uint32_t index;
+	if (!m_freeSlots.empty())
+	{
+		index = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		index = (std::uint32_t)m_components.grow();
+		m_generations.push_back(0);
+		m_active.push_back(false);
+		m_ids.push_back(0);
+		m_tags.push_back(Tag::Default);
+	}
+
+	m_active[index] = true;
+	m_ids[index] = id;
+	m_tags[index] = tag;
+	return index;
+}
+
+void EntityPool::release(std::uint32_t index)
+{
+	m_components.reset(index);
+	m_active[index] = false;
+	m_generations[index]++;
+	m_freeSlots.push_back(index);
+}
+
+bool EntityPool::isValid(std::uint32_t index, std::uint32_t generation) const
+{
+	return index < m_generations.size() && m_generations[index] == generation;
+}
+
+size_t EntityPool::size() const
+{
+	return m_components.size();
+}
\ No newline at end of file
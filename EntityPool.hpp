@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ComponentStore.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// entity tags are small integers interned by the EntityManager
+// the tags the game uses are fixed compile-time constants, others can be
+// registered by name at runtime and are numbered after Tag::BuiltinCount
+typedef size_t EntityTag;
+
+namespace Tag
+{
+	enum : EntityTag
+	{
+		Default,
+		Player,
+		Tile,
+		Dec,
+		Bullet,
+		BuiltinCount
+	};
+}
+
+// slab of entity slots owned by an EntityManager
+// a slot holds the entity's bookkeeping and its components, and is recycled
+// once the entity is removed; every recycle bumps the slot's generation so
+// handles to the previous occupant can be detected as stale
+class EntityPool
+{
+	friend class Entity;
+	friend class EntityManager;
+
+	ComponentStore				m_components;
+	std::vector<std::uint32_t>	m_generations;
+	std::vector<char>			m_active;
+	std::vector<size_t>			m_ids;
+	std::vector<EntityTag>		m_tags;
+	std::vector<std::uint32_t>	m_freeSlots;
+	std::vector<std::uint32_t>	m_destroyed;	// slots destroyed since the manager last updated
+
+public:
+
+	EntityPool();
+
+	// returns the index of a slot for a new entity, reusing a free one if possible
+	std::uint32_t allocate(size_t id, EntityTag tag);
+	void release(std::uint32_t index);
+
+	bool isValid(std::uint32_t index, std::uint32_t generation) const;
+	size_t size() const;
+};
\ No newline at end of file
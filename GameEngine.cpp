@@ -4,18 +4,33 @@
 #include "Scene_Menu.hpp"
 
 #include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cassert>
+#include <algorithm>
 
-GameEngine::GameEngine(const std::string& path)
+GameEngine::GameEngine(const std::string& path, bool headless, size_t width, size_t height)
+	: m_headless(headless)
+	, m_width(width)
+	, m_height(height)
 {
 	init(path);
 }
 
 void GameEngine::init(const std::string& path)
 {
-	m_assets.loadFromFile(path);
+	m_assets.loadFromFile(path, m_headless);
 
-	m_window.create(sf::VideoMode(1280, 768), "Definitely Not Mario");
-	m_window.setFramerateLimit(60);
+	// a headless engine never touches the display or creates a GL context,
+	// the world dimensions come from the engine config instead of the window
+	if (!m_headless)
+	{
+		m_window = std::make_unique<sf::RenderWindow>(sf::VideoMode(m_width, m_height), "Definitely Not Mario");
+		m_window->setFramerateLimit(60);
+		m_profilerText = TextBatch(m_assets.getFont("Roboto"), 12);
+	}
+
+	m_clock.restart();
 
 	changeScene("MENU", std::make_shared<Scene_Menu>(this));
 }
@@ -27,12 +42,28 @@ std::shared_ptr<Scene> GameEngine::currentScene()
 
 bool GameEngine::isRunning()
 {
-	return m_running && m_window.isOpen();
+	return m_running && (m_headless || m_window->isOpen());
+}
+
+bool GameEngine::isHeadless() const
+{
+	return m_headless;
+}
+
+size_t GameEngine::width() const
+{
+	return m_width;
+}
+
+size_t GameEngine::height() const
+{
+	return m_height;
 }
 
 sf::RenderWindow& GameEngine::window()
 {
-	return m_window;
+	assert(m_window && "no window exists in headless mode");
+	return *m_window;
 }
 
 void GameEngine::run()
@@ -43,10 +74,18 @@ void GameEngine::run()
 	}
 }
 
+void GameEngine::run(size_t frames)
+{
+	for (size_t i = 0; i < frames && isRunning(); i++)
+	{
+		update();
+	}
+}
+
 void GameEngine::sUserInput()
 {
 	sf::Event event;
-	while (m_window.pollEvent(event))
+	while (m_window->pollEvent(event))
 	{
 		if (event.type == sf::Event::Closed)
 		{
@@ -55,12 +94,17 @@ void GameEngine::sUserInput()
 
 		if (event.type == sf::Event::KeyPressed)
 		{
+			if (event.key.code == sf::Keyboard::F3)
+			{
+				m_drawProfiler = !m_drawProfiler;
+			}
+
 			if (event.key.code == sf::Keyboard::X)
 			{
 				std::cout << "screenshot saved to " << "test.png" << std::endl;
 				sf::Texture texture;
-				texture.create(m_window.getSize().x, m_window.getSize().y);
-				texture.update(m_window);
+				texture.create(m_window->getSize().x, m_window->getSize().y);
+				texture.update(*m_window);
 				if (texture.copyToImage().saveToFile("test.png"))
 				{
 					std::cout << "screenshot saved to " << "test.png" << std::endl;
@@ -71,16 +115,19 @@ void GameEngine::sUserInput()
 		if (event.type == sf::Event::KeyPressed || event.type == sf::Event::KeyReleased)
 		{
 			// if the current scene does not have an action associated with this key, skip the event
-			if (currentScene()->getActionMap().find(event.key.code) == currentScene()->getActionMap().end())
+			const ActionId name = currentScene()->getAction(event.key.code);
+			if (name == ActionName::None)
 			{
 				continue;
 			}
 
 			// determine start or end action by whether it was key pres or release
-			const std::string actionType = (event.type == sf::Event::KeyPressed) ? "START" : "END";
+			const ActionType actionType = (event.type == sf::Event::KeyPressed) ? ActionType::Start : ActionType::End;
 
-			// look up the action and send the action to the scene
-			currentScene()->doAction(Action(currentScene()->getActionMap().at(event.key.code), actionType));
+			// send the action to the scene, both are plain integers so nothing is allocated per event
+			const Action action(name, actionType);
+			if (m_recording) { m_actionLog.record(position(), action); }
+			currentScene()->doAction(action);
 		}
 	}
 }
@@ -106,6 +153,61 @@ void GameEngine::changeScene(const std::string& sceneName, std::shared_ptr<Scene
 	}
 
 	m_currentScene = sceneName;
+	m_sceneChanges++;
+}
+
+ActionLog::Position GameEngine::position()
+{
+	ActionLog::Position position;
+	position.scene = m_sceneChanges;
+	position.frame = (uint32_t)currentScene()->currentFrame();
+	return position;
+}
+
+void GameEngine::startRecording()
+{
+	m_actionLog.clear();
+	m_recording = true;
+}
+
+bool GameEngine::saveRecording(const std::string& path)
+{
+	m_actionLog.finish(position());
+	return m_actionLog.save(path);
+}
+
+size_t GameEngine::replay(const ActionLog& log)
+{
+	// the log ends at a position, not at a quit, so a replayed QUIT does not stop the replay early
+	// and the steps the recorded session simulated after it are run as well
+	size_t next = 0;
+	size_t steps = 0;
+	while (true)
+	{
+		PROFILE_FRAME();
+
+		for (; next < log.size() && !(position() < log.entry(next).at); next++)
+		{
+			if (!(log.entry(next).at == position()))
+			{
+				std::cerr << "Warning: replay is out of sync, action " << next << " was recorded at an earlier step" << std::endl;
+			}
+			currentScene()->doAction(log.action(next));
+		}
+
+		if (!(position() < log.end())) { break; }
+
+		PROFILE_SCOPE("simulate");
+		currentScene()->simulate(1);
+		steps++;
+	}
+
+	return steps;
+}
+
+std::string GameEngine::summary()
+{
+	return m_currentScene + ": " + currentScene()->summary();
 }
 
 void GameEngine::update()
@@ -114,11 +216,74 @@ void GameEngine::update()
 
 	if (m_sceneMap.empty()) { return; }
 
-	m_sceneMap.at(m_currentScene)->update();
-	sUserInput();
-	currentScene()->simulate(m_simulationSpeed);
-	currentScene()->sRender();
-	m_window.display();
+	PROFILE_FRAME();
+
+	if (m_headless)
+	{
+		PROFILE_SCOPE("simulate");
+		currentScene()->simulate(m_simulationSpeed);
+		return;
+	}
+
+	{ PROFILE_SCOPE("sUserInput"); sUserInput(); }
+	{ PROFILE_SCOPE("simulate"); currentScene()->simulate(stepsThisFrame()); }
+	{ PROFILE_SCOPE("sRender"); currentScene()->sRender(); }
+	if (m_drawProfiler) { PROFILE_SCOPE("sProfiler"); sProfiler(); }
+	{ PROFILE_SCOPE("display"); m_window->display(); }
+}
+
+// per-system timings of recent frames, drawn over the scene in screen coordinates
+void GameEngine::sProfiler()
+{
+	// the numbers are refreshed twice a second so they can be read, and the overlay stays cheap
+	if (m_profilerFrame++ % 30 == 0)
+	{
+		m_profilerStats = Profiler::instance().stats(120);
+	}
+
+	const sf::View view = m_window->getView();
+	m_window->setView(m_window->getDefaultView());
+
+	const float rowHeight = 16;
+	sf::RectangleShape background(sf::Vector2f(340, rowHeight * (m_profilerStats.size() + 1) + 10));
+	background.setPosition((float)m_width - 350, 10);
+	background.setFillColor(sf::Color(0, 0, 0, 160));
+	m_window->draw(background);
+
+	const sf::Vector2f origin((float)m_width - 345, 12);
+	m_profilerText.begin();
+	m_profilerText.set(0, MARIO_PROFILE ? "system                      min / avg / p99 ms" : "profiler compiled out (MARIO_PROFILE=0)", origin);
+
+	for (size_t i = 0; i < m_profilerStats.size(); i++)
+	{
+		const auto& s = m_profilerStats[i];
+		std::ostringstream row;
+		row << std::fixed << std::setprecision(3) << std::left << std::setw(28) << s.name << s.min << " / " << s.avg << " / " << s.p99;
+		m_profilerText.set(i + 1, row.str(), sf::Vector2f(origin.x, origin.y + rowHeight * (i + 1)));
+	}
+
+	m_profilerText.draw(*m_window);
+	m_window->setView(view);
+}
+
+// returns how many fixed simulation steps should run this rendered frame
+// wall-clock time is scaled by the simulation speed and banked in an accumulator,
+// so the simulation advances at the same rate no matter how fast we render
+size_t GameEngine::stepsThisFrame()
+{
+	// clamp long stalls (window drag, breakpoints) so we don't try to catch up forever
+	const float elapsed = std::min(m_clock.restart().asSeconds(), 0.25f);
+	m_accumulator += elapsed * m_simulationSpeed;
+
+	const size_t steps = (size_t)(m_accumulator / m_timeStep);
+	m_accumulator -= steps * m_timeStep;
+	return steps;
+}
+
+void GameEngine::setSimulationSpeed(size_t speed)
+{
+	m_simulationSpeed = speed;
+	m_accumulator = 0.0f;
 }
 
 void GameEngine::quit()
@@ -126,6 +291,11 @@ void GameEngine::quit()
 	m_running = false;
 }
 
+JobSystem& GameEngine::jobs()
+{
+	return m_jobs;
+}
+
 const Assets& GameEngine::assets() const
 {
 	return m_assets;
@@ -2,6 +2,10 @@
 
 #include "Scene.hpp"
 #include "Assets.hpp"
+#include "ActionLog.hpp"
+#include "Profiler.hpp"
+#include "TextBatch.hpp"
+#include "JobSystem.hpp"
 
 #include <memory>
 
@@ -12,30 +16,65 @@ class GameEngine
 
 protected:
 
-	sf::RenderWindow	m_window;
+	std::unique_ptr<sf::RenderWindow>	m_window;	// null when running headless
 	Assets				m_assets;
 	std::string			m_currentScene;
 	SceneMap			m_sceneMap;
-	size_t				m_simulationSpeed = 1;
+	size_t				m_simulationSpeed = 1;		// fixed steps simulated per step of wall-clock time
+	const float			m_timeStep = 1.0f / 60.0f;	// duration of one fixed simulation step in seconds
+	float				m_accumulator = 0.0f;		// wall-clock time not yet consumed by fixed steps
+	sf::Clock			m_clock;
 	bool				m_running = true;
+	bool				m_headless = false;
+	size_t				m_width = 1280;
+	size_t				m_height = 768;
+	bool				m_drawProfiler = false;		// toggled with F3
+	size_t				m_profilerFrame = 0;
+	std::vector<Profiler::Stats>	m_profilerStats;
+	TextBatch			m_profilerText;
+	uint32_t			m_sceneChanges = 0;			// the scene part of an ActionLog::Position
+	bool				m_recording = false;
+	ActionLog			m_actionLog;
+	JobSystem			m_jobs;
 
 	void init(const std::string& path);
 	void update();
 
 	void sUserInput();
+	void sProfiler();
+	size_t stepsThisFrame();
+	ActionLog::Position position();
 
 	std::shared_ptr<Scene> currentScene();
 
 public:
 
-	GameEngine(const std::string& path);
+	GameEngine(const std::string& path, bool headless = false, size_t width = 1280, size_t height = 768);
 
 	void changeScene(const std::string& sceneName, std::shared_ptr<Scene> scene, bool endCurrentScene = false);
 
+	void setSimulationSpeed(size_t speed);
+
 	void quit();
 	void run();
+	void run(size_t frames);
+
+	// records every action sent by sUserInput, saveRecording writes them with the step the session ended at
+	void startRecording();
+	bool saveRecording(const std::string& path);
+
+	// runs a recorded session headless, each action is sent at the step it was recorded at
+	// returns the number of steps simulated
+	size_t replay(const ActionLog& log);
+
+	// the current scene's frame and entity counts, for comparing the end of runs between builds
+	std::string summary();
 
 	sf::RenderWindow& window();
+	JobSystem& jobs();
 	const Assets& assets() const;
 	bool isRunning();
+	bool isHeadless() const;
+	size_t width() const;
+	size_t height() const;
 };
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	// the queue of the worker running on this thread, the owner of the job system's last queue otherwise
+	thread_local const JobSystem*	CurrentSystem = nullptr;
+	thread_local size_t				CurrentWorker = 0;
+}
+
+size_t JobSystem::defaultWorkerCount()
+{
+	unsigned hardware = std::thread::hardware_concurrency();
+	return hardware > 1 ? hardware - 1 : 0;
+}
+
+JobSystem::JobSystem(size_t workers)
+{
+	start(workers);
+}
+
+JobSystem::~JobSystem()
+{
+	stop();
+}
+
+void JobSystem::start(size_t workers)
+{
+	m_stopping = false;
+	for (size_t i = 0; i <= workers; i++)
+	{
+		m_queues.push_back(std::make_unique<Queue>());
+	}
+
+	for (size_t i = 0; i < workers; i++)
+	{
+		m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+	}
+}
+
+void JobSystem::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+	m_queues.clear();
+}
+
+void JobSystem::setWorkerCount(size_t workers)
+{
+	if (workers == m_workers.size()) { return; }
+
+	stop();
+	start(workers);
+}
+
+size_t JobSystem::workerCount() const
+{
+	return m_workers.size();
+}
+
+size_t JobSystem::queueIndex() const
+{
+	return CurrentSystem == this ? CurrentWorker : m_queues.size() - 1;
+}
+
+bool JobSystem::runOne(size_t queue)
+{
+	Task task;
+	bool found = false;
+
+	// the newest job of our own queue, then the oldest of the others, starting with the next one
+	{
+		Queue& own = *m_queues[queue];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty())
+		{
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			m_queued--;
+			found = true;
+		}
+	}
+
+	for (size_t i = 1; !found && i < m_queues.size(); i++)
+	{
+		Queue& other = *m_queues[(queue + i) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(other.mutex);
+		if (!other.tasks.empty())
+		{
+			task = std::move(other.tasks.front());
+			other.tasks.pop_front();
+			m_queued--;
+			found = true;
+		}
+	}
+
+	if (!found) { return false; }
+
+	task.job();
+	task.group->m_pending.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+void JobSystem::workerLoop(size_t index)
+{
+	CurrentSystem = this;
+	CurrentWorker = index;
+
+	while (true)
+	{
+		if (runOne(index)) { continue; }
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wake.wait(lock, [this]() { return m_stopping || m_queued > 0; });
+		if (m_stopping) { return; }
+	}
+}
+
+void JobSystem::submit(Group& group, Job job)
+{
+	// without workers the job runs right away, which keeps single core machines free of any queueing
+	if (m_workers.empty())
+	{
+		job();
+		return;
+	}
+
+	group.m_pending++;
+	{
+		Queue& queue = *m_queues[queueIndex()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back({ std::move(job), &group });
+
+		// counted under the same lock as the push, so the pop that takes the job always sees the count first
+		m_queued++;
+	}
+
+	// taking the sleep lock after counting the job means a worker either sees the count or is already waiting
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_wake.notify_one();
+}
+
+void JobSystem::wait(Group& group)
+{
+	const size_t queue = queueIndex();
+	while (group.m_pending.load(std::memory_order_acquire) > 0)
+	{
+		if (!runOne(queue)) { std::this_thread::yield(); }
+	}
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body)
+{
+	if (m_workers.empty() || count <= grain)
+	{
+		body(0, count);
+		return;
+	}
+
+	// a few ranges per thread, so threads that finish early can steal the rest
+	size_t ranges = std::min((count + grain - 1) / grain, (m_workers.size() + 1) * 4);
+	size_t size = (count + ranges - 1) / ranges;
+
+	Group group;
+	for (size_t begin = size; begin < count; begin += size)
+	{
+		size_t end = std::min(begin + size, count);
+		submit(group, [&body, begin, end]() { body(begin, end); });
+	}
+
+	body(0, std::min(size, count));
+	wait(group);
+}
\ No newline at end of file
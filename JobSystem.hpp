@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a fixed pool of worker threads, each with its own queue of jobs
+// a thread takes the newest job of its own queue first and steals the oldest job of another queue
+// when its own is empty, so nested work stays local and big early jobs are spread out
+// a thread waiting on a group runs queued jobs instead of blocking, so jobs can wait on jobs
+class JobSystem
+{
+public:
+
+	typedef std::function<void()> Job;
+
+	// jobs that are waited on together
+	class Group
+	{
+		friend class JobSystem;
+		std::atomic<size_t>		m_pending { 0 };
+	};
+
+private:
+
+	struct Task
+	{
+		Job			job;
+		Group*		group = nullptr;
+	};
+
+	struct Queue
+	{
+		std::mutex			mutex;
+		std::deque<Task>	tasks;
+	};
+
+	std::vector<std::unique_ptr<Queue>>	m_queues;		// one per worker, the last one for every other thread
+	std::vector<std::thread>			m_workers;
+	std::atomic<size_t>					m_queued { 0 };
+	bool								m_stopping = false;
+	std::mutex							m_sleepMutex;
+	std::condition_variable				m_wake;
+
+	size_t queueIndex() const;
+	bool runOne(size_t queue);
+	void workerLoop(size_t index);
+	void start(size_t workers);
+	void stop();
+
+public:
+
+	// one worker less than the hardware threads, since the thread that submits work runs jobs too
+	static size_t defaultWorkerCount();
+
+	JobSystem(size_t workers = defaultWorkerCount());
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// must not be called while jobs are queued
+	void setWorkerCount(size_t workers);
+	size_t workerCount() const;
+
+	void submit(Group& group, Job job);
+	void wait(Group& group);
+
+	// calls body(begin, end) on ranges that cover [0, count), in parallel once count is over grain
+	void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+};
\ No newline at end of file
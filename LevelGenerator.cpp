@@ -0,0 +1,62 @@
+#include "LevelGenerator.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+
+size_t LevelGenerator::widthFor(size_t tiles, float density)
+{
+	// one ground tile per column plus the expected tiles above it
+	return std::max((size_t)1, (size_t)(tiles / (1.0f + Height * density)));
+}
+
+size_t LevelGenerator::write(const std::string& path, const Settings& settings)
+{
+	std::ofstream file(path, std::ios::trunc);
+	if (!file) { return 0; }
+
+	std::mt19937 rng(settings.seed);
+	std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+	std::uniform_int_distribution<size_t> column(0, settings.width - 1);
+
+	// the same player as level1
+	file << "Player\t2 6 48 48 5 -20 20 0.75 Buster\n";
+
+	size_t tiles = 0;
+	size_t gap = 0;
+	for (size_t x = 0; x < settings.width; x++)
+	{
+		// pits two columns wide, but never under the start
+		if (gap > 0) { gap--; }
+		else if (x > 8 && chance(rng) < 0.03f) { gap = 1; }
+		else
+		{
+			file << "Tile\tGround " << x << " 0\n";
+			tiles++;
+		}
+
+		for (int y = 1; y <= Height; y++)
+		{
+			// the columns around the start stay free so the player spawns and lands on the ground
+			if (x < 5) { continue; }
+			if (chance(rng) >= settings.density) { continue; }
+
+			// the rows the player runs through only get Bricks, which can be shot away
+			float kind = chance(rng);
+			const char* name = (y <= 2 || kind < settings.brickRatio) ? "Brick"
+				: kind < settings.brickRatio + settings.questionRatio ? "Question" : "Block";
+			file << "Tile\t" << name << " " << x << " " << y << "\n";
+			tiles++;
+		}
+	}
+
+	static const char* clouds[] = { "CloudBig", "CloudSmall" };
+	static const char* bushes[] = { "Bush", "BushBig" };
+	for (size_t i = 0; i < settings.decorations; i++)
+	{
+		if (chance(rng) < 0.5f) { file << "Dec\t" << clouds[rng() % 2] << " " << column(rng) << " " << Height + 1 + rng() % 2 << "\n"; }
+		else { file << "Dec\t" << bushes[rng() % 2] << " " << column(rng) << " 1\n"; }
+	}
+
+	return file.good() ? tiles : 0;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+// writes random levels in the Tile / Dec / Player syntax of the shipped levels, for stress testing
+// the same settings and seed always give the same level
+class LevelGenerator
+{
+public:
+
+	struct Settings
+	{
+		size_t			width = 1000;			// grid columns
+		float			density = 0.1f;			// chance of each cell above the ground holding a tile
+		float			brickRatio = 0.3f;		// share of those tiles that are Bricks, all of them in the lowest two rows
+		float			questionRatio = 0.1f;	// and Questions, the rest are Blocks
+		size_t			decorations = 100;
+		unsigned		seed = 1;
+	};
+
+	static const int	Height = 8;				// rows above the ground that can hold tiles
+
+	// the width that gives about the given number of tiles at a density
+	static size_t widthFor(size_t tiles, float density);
+
+	// returns the number of tiles written, 0 if the file could not be written
+	static size_t write(const std::string& path, const Settings& settings);
+};
\ No newline at end of file
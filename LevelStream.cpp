@@ -0,0 +1,384 @@
+#include "LevelStream.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+	// compiled level layout, every section is a flat array so the mapping is read in place:
+	// FileHeader, FileString names[nameCount], FileString directives[directiveCount],
+	// FileChunk chunks[chunkCount], FileRecord records[recordCount], char strings[stringBytes]
+	const char		LevelMagic[4] = { 'M', 'L', 'V', 'L' };
+	const uint32_t	LevelVersion = 2;
+
+	struct FileHeader
+	{
+		char		magic[4];
+		uint32_t	version;
+		uint64_t	assetHash;			// the positions below depend on the animation sizes
+		float		cellWidth, cellHeight, worldHeight, scale;
+		uint32_t	nameCount;
+		uint32_t	directiveCount;
+		uint32_t	chunkCount;
+		uint32_t	recordCount;
+		uint32_t	stringBytes;
+		uint32_t	padding;			// keeps the header a multiple of 8 bytes
+	};
+
+	struct FileString
+	{
+		uint32_t	offset, length;			// into the string section
+	};
+
+	struct FileChunk
+	{
+		uint32_t	first, count;			// records of a chunk are contiguous and sorted by x
+	};
+
+	struct FileRecord
+	{
+		uint16_t	name;
+		uint8_t		tile;
+		uint8_t		inTileMap;
+		float		gx, gy;
+		float		px, py;
+	};
+
+	static_assert(sizeof(FileHeader) == 56 && sizeof(FileString) == 8 && sizeof(FileChunk) == 8 && sizeof(FileRecord) == 20,
+		"compiled level structs must not be padded");
+
+	template <typename T>
+	const T* section(const char* data, size_t& offset, size_t count)
+	{
+		const T* p = reinterpret_cast<const T*>(data + offset);
+		offset += count * sizeof(T);
+		return p;
+	}
+}
+
+bool LevelStream::Placement::operator == (const Placement& rhs) const
+{
+	return cellWidth == rhs.cellWidth && cellHeight == rhs.cellHeight && worldHeight == rhs.worldHeight && scale == rhs.scale && assetHash == rhs.assetHash;
+}
+
+LevelStream::LevelStream()
+{
+
+}
+
+bool LevelStream::open(const std::string& path, const Placement& placement)
+{
+	// a compiled level older than its text is stale and ignored
+	std::error_code error;
+	std::string compiled = compiledPath(path);
+	if (compiled != path && std::filesystem::exists(compiled, error))
+	{
+		bool stale = std::filesystem::exists(path, error) &&
+			std::filesystem::last_write_time(compiled, error) < std::filesystem::last_write_time(path, error);
+
+		if (stale) { std::cerr << "Ignoring stale compiled level " << compiled << std::endl; }
+		else if (openCompiled(compiled, placement)) { return true; }
+	}
+
+	return compiled == path ? openCompiled(path, placement) : openText(path);
+}
+
+bool LevelStream::openCompiled(const std::string& path, const Placement& placement)
+{
+	m_text.clear();
+	m_chunks.clear();
+	m_directives.clear();
+	m_animationNames.clear();
+	m_chunkCount = 0;
+
+	if (!m_file.open(path)) { return false; }
+
+	const char* data = m_file.data();
+	const FileHeader* header = reinterpret_cast<const FileHeader*>(data);
+	if (m_file.size() < sizeof(FileHeader) || std::memcmp(header->magic, LevelMagic, 4) != 0 || header->version != LevelVersion)
+	{
+		std::cerr << "Not a compiled level (version " << LevelVersion << "): " << path << std::endl;
+		m_file.close();
+		return false;
+	}
+
+	// counts are widened before they are added, so a corrupt header cannot wrap the sum to the file size
+	size_t expected = sizeof(FileHeader) + ((size_t)header->nameCount + header->directiveCount) * sizeof(FileString) +
+		(size_t)header->chunkCount * sizeof(FileChunk) + (size_t)header->recordCount * sizeof(FileRecord) + header->stringBytes;
+	Placement compiledFor;
+	compiledFor.cellWidth = header->cellWidth;
+	compiledFor.cellHeight = header->cellHeight;
+	compiledFor.worldHeight = header->worldHeight;
+	compiledFor.scale = header->scale;
+	compiledFor.assetHash = header->assetHash;
+	if (m_file.size() != expected)
+	{
+		std::cerr << "Compiled level does not match this build, recompile it: " << path << std::endl;
+		m_file.close();
+		return false;
+	}
+
+	// tiles were placed with the animation sizes at compile time, a changed sprite or assets.txt moves them
+	if (!(compiledFor == placement))
+	{
+		std::cerr << "Compiled level was built for other settings or assets, recompile it: " << path << std::endl;
+		m_file.close();
+		return false;
+	}
+
+	size_t offset = sizeof(FileHeader);
+	const FileString* names = section<FileString>(data, offset, header->nameCount);
+	const FileString* directives = section<FileString>(data, offset, header->directiveCount);
+	const FileChunk* chunks = section<FileChunk>(data, offset, header->chunkCount);
+	const FileRecord* records = section<FileRecord>(data, offset, header->recordCount);
+	const char* strings = data + offset;
+
+	// every index into the mapping is checked here once, readChunk runs on worker threads and trusts them
+	auto inStrings = [&](const FileString& s) { return (size_t)s.offset + s.length <= header->stringBytes; };
+	bool valid = std::all_of(names, names + header->nameCount, inStrings) &&
+		std::all_of(directives, directives + header->directiveCount, inStrings) &&
+		std::all_of(chunks, chunks + header->chunkCount, [&](const FileChunk& c) { return (size_t)c.first + c.count <= header->recordCount; }) &&
+		std::all_of(records, records + header->recordCount, [&](const FileRecord& r) { return r.name < header->nameCount; });
+	if (!valid)
+	{
+		std::cerr << "Compiled level is corrupt, recompile it: " << path << std::endl;
+		m_file.close();
+		return false;
+	}
+
+	for (uint32_t i = 0; i < header->nameCount; i++)
+	{
+		m_animationNames.emplace_back(strings + names[i].offset, names[i].length);
+	}
+	for (uint32_t i = 0; i < header->directiveCount; i++)
+	{
+		m_directives.emplace_back(strings + directives[i].offset, directives[i].length);
+	}
+
+	m_chunkCount = header->chunkCount;
+	return true;
+}
+
+bool LevelStream::openText(const std::string& path)
+{
+	m_text.clear();
+	m_chunks.clear();
+	m_directives.clear();
+	m_animationNames.clear();
+	m_file.close();
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file) { return false; }
+
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	m_text = buffer.str();
+
+	// index the file a token at a time, only the x coordinate of a Tile / Dec line is converted
+	size_t pos = 0;
+	auto nextToken = [&](size_t& start, size_t& end)
+	{
+		start = m_text.find_first_not_of(" \t\r\n", pos);
+		if (start == std::string::npos) { start = end = pos = m_text.size(); return false; }
+		end = m_text.find_first_of(" \t\r\n", start);
+		if (end == std::string::npos) { end = m_text.size(); }
+		pos = end;
+		return true;
+	};
+
+	size_t start, end;
+	while (nextToken(start, end))
+	{
+		std::string type = m_text.substr(start, end - start);
+
+		if (type == "Tile" || type == "Dec")
+		{
+			size_t lineStart = start, nameStart, xStart, yEnd;
+			if (!nextToken(nameStart, end) || !nextToken(xStart, end) || !nextToken(start, yEnd)) { break; }
+
+			size_t chunk = (size_t)chunkOf(std::strtof(m_text.c_str() + xStart, nullptr));
+			if (chunk >= m_chunks.size()) { m_chunks.resize(chunk + 1); }
+			m_chunks[chunk].push_back(Span(lineStart, yEnd - lineStart));
+		}
+		else if (type == "Player")
+		{
+			// the 9 player properties follow on the same line
+			size_t lineStart = start;
+			for (int i = 0; i < 9 && nextToken(start, end); i++) {}
+			m_directives.push_back(m_text.substr(lineStart, end - lineStart));
+		}
+		else
+		{
+			m_directives.push_back(type);
+		}
+	}
+
+	m_chunkCount = m_chunks.size();
+	return true;
+}
+
+bool LevelStream::isCompiled() const
+{
+	return m_file.isOpen();
+}
+
+size_t LevelStream::chunkCount() const
+{
+	return m_chunkCount;
+}
+
+int LevelStream::chunkOf(float gx) const
+{
+	// anything left of the level start belongs to the first chunk
+	return std::max(0, (int)std::floor(gx / ChunkWidth));
+}
+
+const std::vector<std::string>& LevelStream::directives() const
+{
+	return m_directives;
+}
+
+const std::vector<std::string>& LevelStream::animationNames() const
+{
+	return m_animationNames;
+}
+
+std::vector<LevelStream::Record> LevelStream::parseChunk(size_t chunk) const
+{
+	if (isCompiled()) { return readChunk(chunk); }
+
+	std::vector<Record> records;
+	if (chunk >= m_chunks.size()) { return records; }
+
+	records.reserve(m_chunks[chunk].size());
+	for (auto& span : m_chunks[chunk])
+	{
+		std::istringstream line(m_text.substr(span.first, span.second));
+		std::string type;
+
+		Record record;
+		line >> type >> record.name >> record.gx >> record.gy;
+		record.tile = type == "Tile";
+		records.push_back(record);
+	}
+
+	return records;
+}
+
+std::vector<LevelStream::Record> LevelStream::readChunk(size_t chunk) const
+{
+	std::vector<Record> records;
+	if (chunk >= m_chunkCount) { return records; }
+
+	const char* data = m_file.data();
+	const FileHeader* header = reinterpret_cast<const FileHeader*>(data);
+	size_t offset = sizeof(FileHeader) + ((size_t)header->nameCount + header->directiveCount) * sizeof(FileString);
+	const FileChunk* chunks = section<FileChunk>(data, offset, header->chunkCount);
+	const FileRecord* fileRecords = section<FileRecord>(data, offset, header->recordCount);
+
+	records.resize(chunks[chunk].count);
+	for (uint32_t i = 0; i < chunks[chunk].count; i++)
+	{
+		const FileRecord& in = fileRecords[chunks[chunk].first + i];
+		Record& record = records[i];
+		record.tile = in.tile != 0;
+		record.name = m_animationNames[in.name];
+		record.gx = in.gx;
+		record.gy = in.gy;
+		record.animation = in.name;
+		record.placed = true;
+		record.inTileMap = in.inTileMap != 0;
+		record.pos = Vec2(in.px, in.py);
+	}
+
+	return records;
+}
+
+bool LevelStream::compile(const std::string& path, const Placement& placement, const std::function<void(Record&)>& place) const
+{
+	std::vector<FileString> names, directives;
+	std::vector<FileChunk> chunks;
+	std::vector<FileRecord> records;
+	std::string strings;
+
+	auto addString = [&](const std::string& s)
+	{
+		FileString str = { (uint32_t)strings.size(), (uint32_t)s.size() };
+		strings += s;
+		return str;
+	};
+
+	std::vector<std::string> nameTable;
+	for (size_t c = 0; c < chunkCount(); c++)
+	{
+		std::vector<Record> chunk = parseChunk(c);
+		std::stable_sort(chunk.begin(), chunk.end(), [](const Record& a, const Record& b) { return a.gx < b.gx; });
+
+		chunks.push_back({ (uint32_t)records.size(), (uint32_t)chunk.size() });
+		for (auto& record : chunk)
+		{
+			place(record);
+
+			auto name = std::find(nameTable.begin(), nameTable.end(), record.name);
+			if (name == nameTable.end())
+			{
+				nameTable.push_back(record.name);
+				names.push_back(addString(record.name));
+				name = nameTable.end() - 1;
+			}
+
+			FileRecord out;
+			out.name = (uint16_t)(name - nameTable.begin());
+			out.tile = record.tile;
+			out.inTileMap = record.inTileMap;
+			out.gx = record.gx;
+			out.gy = record.gy;
+			out.px = record.pos.x;
+			out.py = record.pos.y;
+			records.push_back(out);
+		}
+	}
+
+	for (auto& directive : m_directives)
+	{
+		directives.push_back(addString(directive));
+	}
+
+	FileHeader header;
+	std::memcpy(header.magic, LevelMagic, 4);
+	header.version = LevelVersion;
+	header.assetHash = placement.assetHash;
+	header.cellWidth = placement.cellWidth;
+	header.cellHeight = placement.cellHeight;
+	header.worldHeight = placement.worldHeight;
+	header.scale = placement.scale;
+	header.nameCount = (uint32_t)names.size();
+	header.directiveCount = (uint32_t)directives.size();
+	header.chunkCount = (uint32_t)chunks.size();
+	header.recordCount = (uint32_t)records.size();
+	header.stringBytes = (uint32_t)strings.size();
+	header.padding = 0;
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) { return false; }
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(names.data()), names.size() * sizeof(FileString));
+	file.write(reinterpret_cast<const char*>(directives.data()), directives.size() * sizeof(FileString));
+	file.write(reinterpret_cast<const char*>(chunks.data()), chunks.size() * sizeof(FileChunk));
+	file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(FileRecord));
+	file.write(strings.data(), strings.size());
+	return file.good();
+}
+
+std::string LevelStream::compiledPath(const std::string& path)
+{
+	return std::filesystem::path(path).replace_extension(".lvl").string();
+}
\ No newline at end of file
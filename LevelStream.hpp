@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Vec2.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// a level file split into horizontal chunks of grid columns
+// a text level is only read and indexed by open, the lines of a chunk are parsed later with parseChunk,
+// which is safe to call from a worker thread
+// a compiled level (see compile) is memory mapped and its chunks are read straight out of the mapping
+class LevelStream
+{
+public:
+
+	static const int ChunkWidth = 16;			// grid columns per chunk
+
+	// one Tile or Dec line of the level file
+	struct Record
+	{
+		bool			tile = true;			// false for a decoration
+		std::string		name;
+		float			gx = 0, gy = 0;
+		bool			destroyed = false;		// set by the scene, a broken brick is never spawned again
+
+		// filled in by compiled levels, so the scene can skip the asset lookup and placement
+		int				animation = -1;			// index into animationNames(), -1 looks the name up
+		bool			placed = false;			// pos and inTileMap below are valid
+		bool			inTileMap = false;
+		Vec2			pos;
+	};
+
+	// the scene settings positions were computed with, a compiled level is only used if they match
+	struct Placement
+	{
+		float			cellWidth = 64, cellHeight = 64;
+		float			worldHeight = 768;
+		float			scale = 1;
+		uint64_t		assetHash = 0;			// Assets::animationHash() of the animations records were placed with
+
+		bool operator == (const Placement& rhs) const;
+	};
+
+private:
+
+	typedef std::pair<size_t, size_t> Span;		// offset and length of one line in m_text
+
+	std::string							m_text;
+	std::vector<std::vector<Span>>		m_chunks;
+	std::vector<std::string>			m_directives;
+
+	MappedFile							m_file;			// open while a compiled level is loaded
+	std::vector<std::string>			m_animationNames;
+	size_t								m_chunkCount = 0;
+
+	bool openCompiled(const std::string& path, const Placement& placement);
+	std::vector<Record> readChunk(size_t chunk) const;
+
+public:
+
+	LevelStream();
+
+	// uses the compiled level next to path if it is valid and not older than the text, otherwise the text
+	bool open(const std::string& path, const Placement& placement);
+	bool openText(const std::string& path);
+
+	bool isCompiled() const;
+	size_t chunkCount() const;
+	int chunkOf(float gx) const;
+
+	// every line that is not a Tile or Dec (the Player line), in file order
+	const std::vector<std::string>& directives() const;
+
+	// the animation names compiled records index into, empty for text levels
+	const std::vector<std::string>& animationNames() const;
+
+	std::vector<Record> parseChunk(size_t chunk) const;
+
+	// writes the opened level as a compiled level, place fills in animation-dependent fields of each record
+	bool compile(const std::string& path, const Placement& placement, const std::function<void(Record&)>& place) const;
+
+	// levelN.txt -> levelN.lvl
+	static std::string compiledPath(const std::string& path);
+};
\ No newline at end of file
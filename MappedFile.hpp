@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+
+// read-only memory mapping of a whole file, the contents are paged in by the OS on first touch
+class MappedFile
+{
+	const char*		m_data = nullptr;
+	size_t			m_size = 0;
+#ifdef _WIN32
+	void*			m_file = nullptr;
+	void*			m_mapping = nullptr;
+#endif
+
+public:
+
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path);
+	void close();
+
+	bool isOpen() const;
+	const char* data() const;
+	size_t size() const;
+};
\ No newline at end of file
@@ -1,23 +1,185 @@
 #include "Physics.hpp"
 #include "Components.hpp"
-#include <cstdlib>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
-Vec2 Physics::GetOverlap(std::shared_ptr<Entity> a, std::shared_ptr<Entity> b)
+#if defined(MARIO_OVERLAP_AVX)
+#include <immintrin.h>
+#elif defined(MARIO_OVERLAP_SSE2)
+#include <emmintrin.h>
+#endif
+
+void Physics::Boxes::clear()
 {
-	Vec2& posA = a->getComponent<CTransform>().pos;
-	Vec2& posB = b->getComponent<CTransform>().pos;
-	Vec2 delta(abs(posA.x - posB.x), abs(posA.y - posB.y));
+	x.clear();
+	y.clear();
+	halfX.clear();
+	halfY.clear();
+}
 
-	return Vec2(a->getComponent<CBoundingBox>().halfSize.x + b->getComponent<CBoundingBox>().halfSize.x - delta.x,
-		a->getComponent<CBoundingBox>().halfSize.y + b->getComponent<CBoundingBox>().halfSize.y - delta.y);
+void Physics::Boxes::push_back(const Vec2& pos, const Vec2& halfSize)
+{
+	x.push_back(pos.x);
+	y.push_back(pos.y);
+	halfX.push_back(halfSize.x);
+	halfY.push_back(halfSize.y);
 }
 
-Vec2 Physics::GetPreviousOverlap(std::shared_ptr<Entity> a, std::shared_ptr<Entity> b)
+size_t Physics::Boxes::size() const
 {
-	Vec2& posA = a->getComponent<CTransform>().pos;
-	Vec2& posB = b->getComponent<CTransform>().prevPos;
-	Vec2 delta(abs(posA.x - posB.x), abs(posA.y - posB.y));
+	return x.size();
+}
 
-	return Vec2(a->getComponent<CBoundingBox>().halfSize.x + b->getComponent<CBoundingBox>().halfSize.x - delta.x,
-		a->getComponent<CBoundingBox>().halfSize.y + b->getComponent<CBoundingBox>().halfSize.y - delta.y);
+bool Physics::Overlaps::hit(size_t index) const
+{
+	return (hits[index / 64] >> (index % 64)) & 1;
+}
+
+Vec2 Physics::Overlaps::operator [] (size_t index) const
+{
+	return Vec2(x[index], y[index]);
+}
+
+Vec2 Physics::GetOverlap(const Vec2& posA, const Vec2& halfSizeA, const Vec2& posB, const Vec2& halfSizeB)
+{
+	// std::abs, the unqualified abs from <cstdlib> is the int overload and truncated the distance
+	Vec2 delta(std::abs(posA.x - posB.x), std::abs(posA.y - posB.y));
+
+	return Vec2(halfSizeA.x + halfSizeB.x - delta.x, halfSizeA.y + halfSizeB.y - delta.y);
+}
+
+Vec2 Physics::GetOverlap(const Entity& a, const Entity& b)
+{
+	return GetOverlap(a.getComponent<CTransform>().pos, a.getComponent<CBoundingBox>().halfSize,
+		b.getComponent<CTransform>().pos, b.getComponent<CBoundingBox>().halfSize);
+}
+
+Vec2 Physics::GetPreviousOverlap(const Entity& a, const Entity& b)
+{
+	return GetOverlap(a.getComponent<CTransform>().pos, a.getComponent<CBoundingBox>().halfSize,
+		b.getComponent<CTransform>().prevPos, b.getComponent<CBoundingBox>().halfSize);
+}
+
+void Physics::GetOverlaps(const Vec2& pos, const Vec2& halfSize, const Boxes& boxes, Overlaps& out)
+{
+	const size_t count = boxes.size();
+	out.x.resize(count);
+	out.y.resize(count);
+	out.hits.assign((count + 63) / 64, 0);
+
+	// the same operations in the same order as GetOverlap, (halfA + halfB) - |posA - posB|, so results match exactly
+	size_t i = 0;
+
+#if defined(MARIO_OVERLAP_AVX)
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 px = _mm256_set1_ps(pos.x), py = _mm256_set1_ps(pos.y);
+	const __m256 hx = _mm256_set1_ps(halfSize.x), hy = _mm256_set1_ps(halfSize.y);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 dx = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(&boxes.x[i]), px));
+		__m256 dy = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(&boxes.y[i]), py));
+		__m256 ox = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(&boxes.halfX[i]), hx), dx);
+		__m256 oy = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(&boxes.halfY[i]), hy), dy);
+		_mm256_storeu_ps(&out.x[i], ox);
+		_mm256_storeu_ps(&out.y[i], oy);
+
+		unsigned mask = _mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(ox, zero, _CMP_GT_OQ), _mm256_cmp_ps(oy, zero, _CMP_GT_OQ)));
+		out.hits[i / 64] |= (std::uint64_t)mask << (i % 64);
+	}
+#elif defined(MARIO_OVERLAP_SSE2)
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 px = _mm_set1_ps(pos.x), py = _mm_set1_ps(pos.y);
+	const __m128 hx = _mm_set1_ps(halfSize.x), hy = _mm_set1_ps(halfSize.y);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 dx = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(&boxes.x[i]), px));
+		__m128 dy = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(&boxes.y[i]), py));
+		__m128 ox = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(&boxes.halfX[i]), hx), dx);
+		__m128 oy = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(&boxes.halfY[i]), hy), dy);
+		_mm_storeu_ps(&out.x[i], ox);
+		_mm_storeu_ps(&out.y[i], oy);
+
+		unsigned mask = _mm_movemask_ps(_mm_and_ps(_mm_cmpgt_ps(ox, zero), _mm_cmpgt_ps(oy, zero)));
+		out.hits[i / 64] |= (std::uint64_t)mask << (i % 64);
+	}
+#endif
+
+	// the boxes left over after the last full vector, or all of them without SIMD
+	for (; i < count; i++)
+	{
+		float ox = boxes.halfX[i] + halfSize.x - std::abs(boxes.x[i] - pos.x);
+		float oy = boxes.halfY[i] + halfSize.y - std::abs(boxes.y[i] - pos.y);
+		out.x[i] = ox;
+		out.y[i] = oy;
+		if (ox > 0 && oy > 0) { out.hits[i / 64] |= (std::uint64_t)1 << (i % 64); }
+	}
+}
+
+bool Physics::Sweep(const Vec2& pos, const Vec2& halfSize, const Vec2& motion, const Vec2& boxPos, const Vec2& boxHalfSize, SweepHit& hit)
+{
+	// slab test of the moving center against the box grown by the mover's half size:
+	// the boxes overlap once they overlap on both axes, and stop when they stop on either
+	const float pDelta[2] = { boxPos.x - pos.x, boxPos.y - pos.y };
+	const float pMotion[2] = { motion.x, motion.y };
+	const float pHalf[2] = { halfSize.x + boxHalfSize.x, halfSize.y + boxHalfSize.y };
+
+	float entry = -std::numeric_limits<float>::infinity();
+	float exit = std::numeric_limits<float>::infinity();
+	int entryAxis = -1;
+
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (pMotion[axis] == 0)
+		{
+			// touching edges do not count, the same as an overlap of 0 in GetOverlap
+			if (std::abs(pDelta[axis]) >= pHalf[axis]) { return false; }
+			continue;
+		}
+
+		float t1 = (pDelta[axis] - pHalf[axis]) / pMotion[axis];
+		float t2 = (pDelta[axis] + pHalf[axis]) / pMotion[axis];
+		if (t1 > t2) { std::swap(t1, t2); }
+
+		if (t1 > entry) { entry = t1; entryAxis = axis; }
+		exit = std::min(exit, t2);
+	}
+
+	if (entryAxis < 0 || entry < 0 || entry > 1 || entry >= exit) { return false; }
+
+	hit.time = entry;
+	hit.normal = Vec2(0, 0);
+	if (entryAxis == 0)	{ hit.normal.x = motion.x > 0 ? -1.0f : 1.0f; }
+	else				{ hit.normal.y = motion.y > 0 ? -1.0f : 1.0f; }
+	return true;
+}
+
+bool Physics::SweepFirst(const Vec2& pos, const Vec2& halfSize, const Vec2& motion, const Boxes& boxes, SweepHit& hit)
+{
+	bool found = false;
+	SweepHit candidate;
+	for (size_t i = 0; i < boxes.size(); i++)
+	{
+		if (Sweep(pos, halfSize, motion, Vec2(boxes.x[i], boxes.y[i]), Vec2(boxes.halfX[i], boxes.halfY[i]), candidate)
+			&& (!found || candidate.time < hit.time))
+		{
+			hit = candidate;
+			hit.index = i;
+			found = true;
+		}
+	}
+	return found;
+}
+
+const char* Physics::OverlapKernel()
+{
+#if defined(MARIO_OVERLAP_AVX)
+	return "AVX";
+#elif defined(MARIO_OVERLAP_SSE2)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
 }
\ No newline at end of file
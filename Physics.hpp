@@ -2,8 +2,61 @@
 
 #include "Entity.hpp"
 
+#include <cstdint>
+#include <vector>
+
+// the batch overlap test uses AVX or SSE2 when the compiler targets them, defining MARIO_NO_SIMD forces the scalar loop
+#if !defined(MARIO_NO_SIMD) && defined(__AVX__)
+#define MARIO_OVERLAP_AVX 1
+#elif !defined(MARIO_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MARIO_OVERLAP_SSE2 1
+#endif
+
 namespace Physics
 {
-	Vec2 GetOverlap(std::shared_ptr<Entity> a, std::shared_ptr<Entity> b);
-	Vec2 GetPreviousOverlap(std::shared_ptr<Entity> a, std::shared_ptr<Entity> b);
+	// boxes in structure-of-arrays layout, so the batch test loads several boxes per instruction
+	struct Boxes
+	{
+		std::vector<float>		x, y;
+		std::vector<float>		halfX, halfY;
+
+		void clear();
+		void push_back(const Vec2& pos, const Vec2& halfSize);
+		size_t size() const;
+	};
+
+	// result of the batch test, box i overlaps the query box with positive area if bit i of hits is set
+	struct Overlaps
+	{
+		std::vector<float>			x, y;
+		std::vector<std::uint64_t>	hits;
+
+		bool hit(size_t index) const;
+		Vec2 operator [] (size_t index) const;
+	};
+
+	// first contact of a box moving by motion over one step
+	struct SweepHit
+	{
+		float		time = 1;			// fraction of the motion done at the contact
+		Vec2		normal;				// points out of the box that was hit, along the axis that touched
+		size_t		index = 0;			// the box hit by SweepFirst
+	};
+
+	Vec2 GetOverlap(const Vec2& posA, const Vec2& halfSizeA, const Vec2& posB, const Vec2& halfSizeB);
+	Vec2 GetOverlap(const Entity& a, const Entity& b);
+	Vec2 GetPreviousOverlap(const Entity& a, const Entity& b);
+
+	// GetOverlap(boxes[i], query) for every box at once, bit for bit the same results as the per-pair function
+	void GetOverlaps(const Vec2& pos, const Vec2& halfSize, const Boxes& boxes, Overlaps& out);
+
+	// swept AABB test of a box moving from pos by motion against a static box, true if they start to overlap
+	// during the motion; boxes that already overlap at the start are left to the discrete overlap test
+	bool Sweep(const Vec2& pos, const Vec2& halfSize, const Vec2& motion, const Vec2& boxPos, const Vec2& boxHalfSize, SweepHit& hit);
+
+	// the earliest Sweep hit among boxes
+	bool SweepFirst(const Vec2& pos, const Vec2& halfSize, const Vec2& motion, const Boxes& boxes, SweepHit& hit);
+
+	// the instruction set GetOverlaps was compiled for: "AVX", "SSE2" or "scalar"
+	const char* OverlapKernel();
 }
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace
+{
+	const std::chrono::steady_clock::time_point ProfilerEpoch = std::chrono::steady_clock::now();
+
+	// small per-thread ids for the trace, in the order threads first record an event
+	uint16_t threadIndex()
+	{
+		static std::atomic<uint16_t> nextThread(0);
+		thread_local uint16_t index = nextThread++;
+		return index;
+	}
+}
+
+Profiler::Profiler()
+	: m_events(Capacity)
+{
+
+}
+
+Profiler& Profiler::instance()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+int64_t Profiler::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - ProfilerEpoch).count();
+}
+
+uint16_t Profiler::registerScope(const char* name)
+{
+	std::lock_guard<std::mutex> lock(m_scopeMutex);
+
+	auto it = std::find(m_scopes.begin(), m_scopes.end(), name);
+	if (it != m_scopes.end()) { return (uint16_t)(it - m_scopes.begin()); }
+
+	m_scopes.push_back(name);
+	return (uint16_t)(m_scopes.size() - 1);
+}
+
+void Profiler::beginFrame()
+{
+	m_frame++;
+}
+
+void Profiler::record(uint16_t scope, int64_t start, int64_t end)
+{
+	// claim the next slot, the oldest event is overwritten once the buffer is full
+	uint64_t index = m_head.fetch_add(1, std::memory_order_relaxed);
+	Event& e = m_events[index % Capacity];
+
+	e.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	e.start = start;
+	e.duration = end - start;
+	e.frame = m_frame.load(std::memory_order_relaxed);
+	e.scope = scope;
+	e.thread = threadIndex();
+	e.sequence.store(index + 1, std::memory_order_release);
+}
+
+bool Profiler::readEvent(uint64_t index, Event& out) const
+{
+	// a slot that is being rewritten changes its sequence, so the copy is only kept if it did not
+	const Event& e = m_events[index % Capacity];
+	if (e.sequence.load(std::memory_order_acquire) != index + 1) { return false; }
+
+	out.start = e.start;
+	out.duration = e.duration;
+	out.frame = e.frame;
+	out.scope = e.scope;
+	out.thread = e.thread;
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return e.sequence.load(std::memory_order_relaxed) == index + 1;
+}
+
+void Profiler::forEachEvent(uint32_t firstFrame, const std::function<void(const Event&)>& visit) const
+{
+	uint64_t head = m_head.load(std::memory_order_acquire);
+	uint64_t first = head > Capacity ? head - Capacity : 0;
+
+	Event e;
+	for (uint64_t i = first; i < head; i++)
+	{
+		if (readEvent(i, e) && e.frame >= firstFrame) { visit(e); }
+	}
+}
+
+std::vector<Profiler::Stats> Profiler::stats(size_t frames) const
+{
+	// the current frame is still running, so only the frames before it count
+	const uint32_t current = m_frame.load();
+	const uint32_t firstFrame = current > frames ? current - (uint32_t)frames : 0;
+
+	size_t scopeCount;
+	std::vector<Stats> result;
+	{
+		std::lock_guard<std::mutex> lock(m_scopeMutex);
+		scopeCount = m_scopes.size();
+		for (auto& name : m_scopes) { result.push_back({ name }); }
+	}
+
+	// total time of each scope in each frame, a scope can run several times per frame
+	std::vector<std::vector<double>> perFrame(scopeCount, std::vector<double>(current - firstFrame, -1.0));
+	forEachEvent(firstFrame, [&](const Event& e)
+	{
+		if (e.frame >= current || e.scope >= scopeCount) { return; }
+
+		double& total = perFrame[e.scope][e.frame - firstFrame];
+		total = std::max(total, 0.0) + e.duration / 1000000.0;
+	});
+
+	for (size_t s = 0; s < scopeCount; s++)
+	{
+		std::vector<double> samples;
+		for (double ms : perFrame[s]) { if (ms >= 0) { samples.push_back(ms); } }
+		if (samples.empty()) { continue; }
+
+		std::sort(samples.begin(), samples.end());
+		double sum = 0;
+		for (double ms : samples) { sum += ms; }
+
+		result[s].min = samples.front();
+		result[s].avg = sum / samples.size();
+		result[s].p99 = samples[(size_t)(0.99 * (samples.size() - 1))];
+		result[s].frames = samples.size();
+	}
+
+	return result;
+}
+
+bool Profiler::save(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file) { return false; }
+
+	std::vector<std::string> scopes;
+	{
+		std::lock_guard<std::mutex> lock(m_scopeMutex);
+		scopes = m_scopes;
+	}
+
+	const bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+	if (csv)
+	{
+		file << "frame,scope,thread,start_us,duration_us\n";
+		forEachEvent(0, [&](const Event& e)
+		{
+			file << e.frame << "," << scopes[e.scope] << "," << e.thread << "," << e.start / 1000.0 << "," << e.duration / 1000.0 << "\n";
+		});
+	}
+	else
+	{
+		// complete ("X") events with microsecond timestamps, the format chrome://tracing and Perfetto load
+		file << "{\"traceEvents\":[";
+		bool first = true;
+		forEachEvent(0, [&](const Event& e)
+		{
+			file << (first ? "\n" : ",\n") << "{\"name\":\"" << scopes[e.scope] << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.thread
+				<< ",\"ts\":" << e.start / 1000.0 << ",\"dur\":" << e.duration / 1000.0 << ",\"args\":{\"frame\":" << e.frame << "}}";
+			first = false;
+		});
+		file << "\n]}\n";
+	}
+
+	return file.good();
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// scoped timers for the engine systems
+// PROFILE_SCOPE("name") times the rest of the enclosing block, PROFILE_FRAME() starts a new frame
+// building with MARIO_PROFILE defined as 0 compiles every timer out
+#ifndef MARIO_PROFILE
+#define MARIO_PROFILE 1
+#endif
+
+class Profiler
+{
+public:
+
+	// milliseconds a scope took per frame, over the frames it ran in
+	struct Stats
+	{
+		std::string		name;
+		double			min = 0, avg = 0, p99 = 0;
+		size_t			frames = 0;
+	};
+
+private:
+
+	// one timed scope, written into a ring buffer that never blocks the writer
+	// a slot's sequence is the event index + 1 once it is completely written, 0 while it is being filled
+	struct Event
+	{
+		std::atomic<uint64_t>	sequence { 0 };
+		int64_t					start = 0;		// nanoseconds since the profiler was created
+		int64_t					duration = 0;
+		uint32_t				frame = 0;
+		uint16_t				scope = 0;
+		uint16_t				thread = 0;
+	};
+
+	static const size_t				Capacity = 1 << 16;
+
+	std::vector<Event>				m_events;
+	std::atomic<uint64_t>			m_head { 0 };
+	std::atomic<uint32_t>			m_frame { 0 };
+	mutable std::mutex				m_scopeMutex;		// only taken the first time a scope runs
+	std::vector<std::string>		m_scopes;
+
+	Profiler();
+
+	bool readEvent(uint64_t index, Event& out) const;
+	void forEachEvent(uint32_t firstFrame, const std::function<void(const Event&)>& visit) const;
+
+public:
+
+	static Profiler& instance();
+	static int64_t now();
+
+	uint16_t registerScope(const char* name);
+	void beginFrame();
+	void record(uint16_t scope, int64_t start, int64_t end);
+
+	// statistics of every scope over the last frames completed frames
+	std::vector<Stats> stats(size_t frames) const;
+
+	// writes the events still in the ring buffer, as CSV if path ends in .csv and as a Chrome trace (chrome://tracing) otherwise
+	bool save(const std::string& path) const;
+};
+
+class ProfileScope
+{
+	uint16_t	m_scope;
+	int64_t		m_start;
+
+public:
+
+	ProfileScope(uint16_t scope)
+		: m_scope(scope), m_start(Profiler::now()) {}
+	~ProfileScope() { Profiler::instance().record(m_scope, m_start, Profiler::now()); }
+};
+
+#if MARIO_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) \
+	static const uint16_t PROFILE_CONCAT(profileScopeId, __LINE__) = Profiler::instance().registerScope(name); \
+	ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileScopeId, __LINE__))
+#define PROFILE_FRAME() Profiler::instance().beginFrame()
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FRAME()
+#endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "Scene.hpp"
 #include "GameEngine.hpp"
 
+#include <sstream>
+
 Scene::Scene()
 {
 
@@ -19,12 +21,12 @@ void Scene::setPaused(bool paused)
 
 size_t Scene::width() const
 {
-	return m_game->window().getSize().x;
+	return m_game->width();
 }
 
 size_t Scene::height() const
 {
-	return m_game->window().getSize().y;
+	return m_game->height();
 }
 
 size_t Scene::currentFrame() const
@@ -32,15 +34,35 @@ size_t Scene::currentFrame() const
 	return m_currentFrame;
 }
 
+// frame and live entity count per tag, tags without entities are left out
+std::string Scene::summary()
+{
+	std::ostringstream out;
+	out << "frame " << m_currentFrame << ", " << m_entityManager.getEntities().size() << " entities";
+	for (EntityTag tag = 0; tag < m_entityManager.tagCount(); tag++)
+	{
+		size_t count = m_entityManager.getEntities(tag).size();
+		if (count > 0) { out << ", " << m_entityManager.tagName(tag) << " " << count; }
+	}
+	return out.str();
+}
+
 void Scene::drawLine(const Vec2& p1, const Vec2& p2)
 {
 	sf::Vertex line[] = { sf::Vector2f(p1.x, p1.y), sf::Vector2f(p2.x, p2.y) };
 	m_game->window().draw(line, 2, sf::Lines);
 }
 
+void Scene::registerAction(int inputKey, ActionId action)
+{
+	if (inputKey < 0) { return; }
+	if ((size_t)inputKey >= m_actionMap.size()) { m_actionMap.resize(inputKey + 1, ActionName::None); }
+	m_actionMap[inputKey] = action;
+}
+
 void Scene::registerAction(int inputKey, const std::string& actionName)
 {
-	m_actionMap[inputKey] = actionName;
+	registerAction(inputKey, Action::registerName(actionName));
 }
 
 const ActionMap& Scene::getActionMap() const
@@ -48,14 +70,26 @@ const ActionMap& Scene::getActionMap() const
 	return m_actionMap;
 }
 
+ActionId Scene::getAction(int inputKey) const
+{
+	if (inputKey < 0 || (size_t)inputKey >= m_actionMap.size()) { return ActionName::None; }
+	return m_actionMap[inputKey];
+}
+
 void Scene::doAction(const Action& action)
 {
 	sDoAction(action);
 }
 
+// runs the full system pipeline for the given number of fixed steps
+// the engine renders once afterwards, so fast-forwarding costs no extra draws
 void Scene::simulate(const size_t frames)
 {
-	m_currentFrame++;
+	for (size_t i = 0; i < frames; i++)
+	{
+		update();
+		m_currentFrame++;
+	}
 }
 
 bool Scene::hasEnded() const
@@ -7,7 +7,8 @@
 
 class GameEngine;
 
-typedef std::map<int, std::string> ActionMap;
+// action of each input key, indexed by key code, ActionName::None for keys without one
+typedef std::vector<ActionId> ActionMap;
 
 class Scene
 {
@@ -29,19 +30,23 @@ public:
 	Scene();
 	Scene(GameEngine* gameEngine);
 
+	// advances the scene by exactly one fixed simulation step, no rendering
 	virtual void update() = 0;
 	virtual void sDoAction(const Action& action) = 0;
 	virtual void sRender() = 0;
 
 	virtual void doAction(const Action& action);
 	void simulate(const size_t frames);
+	void registerAction(int inputKey, ActionId action);
 	void registerAction(int inputKey, const std::string& actionName);
 
 	size_t width() const;
 	size_t height() const;
 	size_t currentFrame() const;
+	virtual std::string summary();
 
 	bool hasEnded() const;
 	const ActionMap& getActionMap() const;
+	ActionId getAction(int inputKey) const;
 	void drawLine(const Vec2& p1, const Vec2& p2);
 };
\ No newline at end of file
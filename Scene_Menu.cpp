@@ -13,11 +13,11 @@ Scene_Menu::Scene_Menu(GameEngine* gameEngine)
 
 void Scene_Menu::init()
 {
-	registerAction(sf::Keyboard::W, "UP");
-	registerAction(sf::Keyboard::S, "DOWN");
-	registerAction(sf::Keyboard::D, "PLAY");
-	registerAction(sf::Keyboard::D, "PLAY");
-	registerAction(sf::Keyboard::Escape, "QUIT");
+	registerAction(sf::Keyboard::W, ActionName::Up);
+	registerAction(sf::Keyboard::S, ActionName::Down);
+	registerAction(sf::Keyboard::D, ActionName::Play);
+	registerAction(sf::Keyboard::D, ActionName::Play);
+	registerAction(sf::Keyboard::Escape, ActionName::Quit);
 
 	m_title = "Mega Mario";
 	m_menuStrings.push_back("Level 1");
@@ -28,8 +28,8 @@ void Scene_Menu::init()
 	m_levelPaths.push_back("level2.txt");
 	m_levelPaths.push_back("level3.txt");
 
-	m_menuText.setFont(m_game->assets().getFont("Pixel"));
-	m_menuText.setCharacterSize(64);
+	m_menuText = TextBatch(m_game->assets().getFont("Pixel"), 64);
+	m_helpText = TextBatch(m_game->assets().getFont("Pixel"), 32);
 }
 
 void Scene_Menu::update()
@@ -39,61 +39,47 @@ void Scene_Menu::update()
 
 void Scene_Menu::sDoAction(const Action& action)
 {
-	if (action.type() == "START")
+	if (action.type() != ActionType::Start) { return; }
+
+	switch (action.id())
 	{
-		if (action.name() == "UP")
-		{
-			if (m_selectedMenuIndex > 0) { m_selectedMenuIndex--; }
-			else { m_selectedMenuIndex = m_menuStrings.size() - 1; }
-		}
-		else if (action.name() == "DOWN")
-		{
-			m_selectedMenuIndex = (m_selectedMenuIndex + 1) % m_menuStrings.size();
-		}
-		else if (action.name() == "PLAY")
-		{
-			m_game->changeScene("PLAY", std::make_shared<Scene_Play>(m_game, m_levelPaths[m_selectedMenuIndex]));
-		}
-		else if (action.name() == "QUIT")
-		{
-			onEnd();
-		}
+	case ActionName::Up:
+		if (m_selectedMenuIndex > 0) { m_selectedMenuIndex--; }
+		else { m_selectedMenuIndex = m_menuStrings.size() - 1; }
+		break;
+
+	case ActionName::Down:
+		m_selectedMenuIndex = (m_selectedMenuIndex + 1) % m_menuStrings.size();
+		break;
+
+	case ActionName::Play:
+		m_game->changeScene("PLAY", std::make_shared<Scene_Play>(m_game, m_levelPaths[m_selectedMenuIndex]));
+		break;
+
+	case ActionName::Quit:
+		onEnd();
+		break;
 	}
 }
 
 void Scene_Menu::sRender()
 {
-	size_t i = 0;
-
 	m_game->window().clear(sf::Color(50, 50, 150));
 
-	m_menuText.setString(m_title);
-	m_menuText.setFillColor(sf::Color(0, 0, 0));
-	m_game->window().draw(m_menuText);
-
-	sf::Text t = m_menuText;
-	t.setPosition(t.getPosition().x, 50 + t.getPosition().y);
+	// the menu strings keep their glyphs, only the two entries whose color changed are laid out again
+	m_menuText.begin();
+	m_menuText.set(0, m_title, sf::Vector2f(0, 0), sf::Color(0, 0, 0));
 
-	for (auto& s : m_menuStrings)
+	for (size_t i = 0; i < m_menuStrings.size(); i++)
 	{
-		t.setString(s);
-		t.setPosition(t.getPosition().x, t.getPosition().y + 100);
-
-		if (i == m_selectedMenuIndex)
-		{
-			t.setFillColor(sf::Color(255, 255, 255));
-		}
-		else { t.setFillColor(sf::Color(0, 0, 0)); }
-
-		m_game->window().draw(t);
-		i++;
+		sf::Color color = (i == m_selectedMenuIndex) ? sf::Color(255, 255, 255) : sf::Color(0, 0, 0);
+		m_menuText.set(i + 1, m_menuStrings[i], sf::Vector2f(0, 150.0f + 100.0f * i), color);
 	}
+	m_menuText.draw(m_game->window());
 
-	t.setString("UP: W    DOWN: S    PLAY: D    BACK: ESC");
-	t.setPosition(t.getPosition().x, t.getPosition().y + 300);
-	t.setFillColor(sf::Color(0, 0, 0));
-	t.setCharacterSize(32);
-	m_game->window().draw(t);
+	m_helpText.begin();
+	m_helpText.set(0, "UP: W    DOWN: S    PLAY: D    BACK: ESC", sf::Vector2f(0, 50.0f + 100.0f * m_menuStrings.size() + 300.0f), sf::Color(0, 0, 0));
+	m_helpText.draw(m_game->window());
 }
 
 void Scene_Menu::onEnd()
@@ -6,6 +6,7 @@
 #include <deque>
 
 #include "EntityManager.hpp"
+#include "TextBatch.hpp"
 
 class Scene_Menu : public Scene
 {
@@ -15,7 +16,8 @@ protected:
 	std::string					m_title;
 	std::vector<std::string>	m_menuStrings;
 	std::vector<std::string>	m_levelPaths;
-	sf::Text					m_menuText;
+	TextBatch					m_menuText;
+	TextBatch					m_helpText;
 	size_t						m_selectedMenuIndex = 0;
 
 	void init();
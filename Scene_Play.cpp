@@ -4,9 +4,14 @@
 #include "GameEngine.hpp"
 #include "Components.hpp"
 #include "Action.hpp"
+#include "Profiler.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <cmath>
 
 Scene_Play::Scene_Play(GameEngine* gameEngine, const std::string& levelPath)
 	: Scene(gameEngine)
@@ -17,23 +22,63 @@ Scene_Play::Scene_Play(GameEngine* gameEngine, const std::string& levelPath)
 
 void Scene_Play::init(const std::string& levelPath)
 {
-	registerAction(sf::Keyboard::P,		"PAUSE");
-	registerAction(sf::Keyboard::Escape,"QUIT");
-	registerAction(sf::Keyboard::T,		"TOGGLE_TEXTURE");		// Toggle drawing (T)extures
-	registerAction(sf::Keyboard::C,		"TOGGLE_COLLISION");	// Toggle drawing (C)ollision Boxes
-	registerAction(sf::Keyboard::G,		"TOGGLE_GRID");			// Toggle drawing (G)rid
-	registerAction(sf::Keyboard::W,		"JUMP");
-	registerAction(sf::Keyboard::A,		"LEFT");
-	registerAction(sf::Keyboard::D,		"RIGHT");
-	registerAction(sf::Keyboard::Space,	"SHOOT");
+	registerAction(sf::Keyboard::P,		ActionName::Pause);
+	registerAction(sf::Keyboard::Escape,ActionName::Quit);
+	registerAction(sf::Keyboard::T,		ActionName::ToggleTexture);		// Toggle drawing (T)extures
+	registerAction(sf::Keyboard::C,		ActionName::ToggleCollision);	// Toggle drawing (C)ollision Boxes
+	registerAction(sf::Keyboard::G,		ActionName::ToggleGrid);			// Toggle drawing (G)rid
+	registerAction(sf::Keyboard::W,		ActionName::Jump);
+	registerAction(sf::Keyboard::A,		ActionName::Left);
+	registerAction(sf::Keyboard::D,		ActionName::Right);
+	registerAction(sf::Keyboard::Space,	ActionName::Shoot);
+
+	m_gridText = TextBatch(m_game->assets().getFont("Roboto"), 12);
+	m_collisionLines.setPrimitiveType(sf::Lines);
+
+	buildStateGraphs();
+	buildSystems();
+	loadLevel(levelPath);
+}
+
+void Scene_Play::buildSystems()
+{
+	// the update pipeline in order, each system declaring what it reads and writes
+	// sMovement and sLifespan touch nothing in common and run concurrently, the rest runs in turn
+	using namespace Access;
+	m_systems.add("sStreaming", All, All, [this]() { sStreaming(); });
+	m_systems.add("EntityManager::update", 0, Structure | Lifetime, [this]() { m_entityManager.update(); });
+	m_systems.add("sMovement",
+		Structure | components<CGravity>(),
+		components<CTransform, CInput, CState, CBody>(),
+		[this]() { sMovement(); });
+	m_systems.add("sLifespan", Structure | components<CLifespan>(), Lifetime, [this]() { sLifespan(); });
+	m_systems.add("sCollision", All, All, [this]() { sCollision(); });
+	m_systems.add("sAnimation",
+		Structure | components<CTransform>(),
+		components<CAnimation, CState>(),
+		[this]() { sAnimation(); });
+}
 
-	m_gridText.setCharacterSize(12);
-	m_gridText.setFont(m_game->assets().getFont("Roboto"));
+void Scene_Play::buildStateGraphs()
+{
+	// the player's transitions, any state not listed for an event stays put
+	m_playerStates = StateGraph(PlayerStateCount, PlayerEventCount);
 
-	loadLevel(levelPath);
+	for (size_t state = 0; state < PlayerStateCount; state++)
+	{
+		m_playerStates.addTransition(state, Jump, Air);
+		m_playerStates.addTransition(state, LandStill, Stand);
+		m_playerStates.addTransition(state, LandMoving, Run);
+	}
+	m_playerStates.addTransition(Stand, Move, Run);
+
+	// resolve the animation of every state once, not every frame
+	m_playerStates.setAnimation(Stand, m_game->assets().getAnimation("Stand"));
+	m_playerStates.setAnimation(Run, m_game->assets().getAnimation("Run"));
+	m_playerStates.setAnimation(Air, m_game->assets().getAnimation("Air"));
 }
 
-Vec2 Scene_Play::gridToMidPixel(float gridX, float gridY, std::shared_ptr<Entity> entity, float scale)
+Vec2 Scene_Play::gridToMidPixel(float gridX, float gridY, Entity entity, float scale)
 {
 	//		 This function takes in a grid (x,y) position and an Entity
 	//		 Return a Vec2 indicating where the CENTER position of the Entity should be
@@ -41,12 +86,16 @@ Vec2 Scene_Play::gridToMidPixel(float gridX, float gridY, std::shared_ptr<Entity
 	//		 The size of the grid width and height is stored in m_gridSize.x and m_gridSize.y
 	//		 The bottom-left corner of the Animation should align with the bottom left of the grid cell
 
-	Vec2 pos = entity->getComponent<CTransform>().pos;
-	Vec2 animPos = entity->getComponent<CAnimation>().animation.getSize();
+	return gridToMidPixel(gridX, gridY, entity.getComponent<CAnimation>().animation, scale);
+}
+
+Vec2 Scene_Play::gridToMidPixel(float gridX, float gridY, const Animation& animation, float scale) const
+{
+	Vec2 animPos = animation.getSize();
 	animPos *= scale;
-	float height = m_game->window().getSize().y;
+	float height = (float)Scene::height();
 
-	if (entity->getComponent<CAnimation>().animation.getName() == "PipeTall")
+	if (animation.getName() == "PipeTall")
 	{
 		return Vec2(gridX * m_gridSize.x + animPos.x / 2.0, height - gridY * m_gridSize.y - (animPos.y / 4.0) * 3.33);
 	}
@@ -54,138 +103,315 @@ Vec2 Scene_Play::gridToMidPixel(float gridX, float gridY, std::shared_ptr<Entity
 	return Vec2(gridX * m_gridSize.x + animPos.x / 2.0, height - gridY * m_gridSize.y - animPos.y / 2.0);
 }
 
+bool Scene_Play::isStaticTile(const Animation& animation, float scale) const
+{
+	const std::string& name = animation.getName();
+	if (name == "Brick" || name == "Question" || name == "Pole" || name == "PoleTop")
+	{
+		return false;
+	}
+
+	return animation.getSize() * scale == m_gridSize;
+}
+
 void Scene_Play::loadLevel(const std::string& filename)
 {
 	// reset the entity manager every time we load a level
 	m_entityManager = EntityManager();
+	m_broadphase = SpatialHash(m_gridSize);
+	m_renderIndex = SpatialHash(m_gridSize * 4);
+	m_tileMap = TileMap(m_gridSize, (float)height());
+	m_chunks = std::vector<StreamedChunk>();
+	m_residentChunks.clear();
 
 	//		 read in the level file and add the appropriate entities
 	//		 use the PlayerConfig struct m_playerConfig to store player properties
 	//		 this struct is defined at the top of Scene_Play.hpp
 
-	std::ifstream file(filename);
-	std::string str;
-	while (file.good())
+	// tiles and decorations are only indexed here, sStreaming creates them chunk by chunk around the camera
+	sf::Clock clock;
+	if (!m_level.open(filename, levelPlacement()))
 	{
-		file >> str;
+		std::cerr << "Could not load level file: " << filename << std::endl;
+	}
+	m_chunks.resize(m_level.chunkCount());
+
+	// a compiled level names each animation once, resolve them here instead of once per record
+	m_levelAnimations.clear();
+	for (auto& name : m_level.animationNames())
+	{
+		m_levelAnimations.push_back(&m_game->assets().getAnimation(name));
+	}
+	std::cout << "Opened " << (m_level.isCompiled() ? "compiled" : "text") << " level " << filename
+		<< " in " << clock.getElapsedTime().asMicroseconds() / 1000.0f << "ms" << std::endl;
 
-		if (str == "Tile")
+	for (auto& directive : m_level.directives())
+	{
+		std::istringstream line(directive);
+		std::string str;
+		line >> str;
+
+		if (str == "Player")
 		{
-			std::string name;
-			float GX, GY;
-			file >> name >> GX >> GY;
+			line >> m_playerConfig.X >> m_playerConfig.Y >> m_playerConfig.CX >> m_playerConfig.CY >> m_playerConfig.SPEED >>
+				m_playerConfig.JUMP >> m_playerConfig.MAXSPEED >> m_playerConfig.GRAVITY >> m_playerConfig.WEAPON;
+		}
+		else
+		{
+			std::cerr << "Unknown Entity Type " << str << std::endl;
+		}
+	}
+
+	spawnPlayer();
+	sStreaming();
+}
 
-			auto tile = m_entityManager.addEntity("tile");
-			tile->addComponent<CAnimation>(m_game->assets().getAnimation(name), true);
+// runs on a worker thread: only reads the level text, the assets and constant scene settings
+Scene_Play::PreparedChunk Scene_Play::prepareChunk(size_t chunk, std::vector<LevelStream::Record> records, bool parsed) const
+{
+	PreparedChunk prepared;
+	prepared.records = parsed ? std::move(records) : m_level.parseChunk(chunk);
 
-			Vec2 mid = gridToMidPixel(GX, GY, tile, 4.0);
+	for (size_t i = 0; i < prepared.records.size(); i++)
+	{
+		auto& record = prepared.records[i];
+		if (record.destroyed) { continue; }
 
-			tile->addComponent<CTransform>(mid, 4.0);
-			tile->getComponent<CAnimation>().animation.getSprite().setScale(tile->getComponent<CTransform>().scale.x, tile->getComponent<CTransform>().scale.y);
-			tile->addComponent<CBoundingBox>(m_game->assets().getAnimation(name).getSize() * 4.0);
+		const Animation& animation = record.animation >= 0 ? *m_levelAnimations[record.animation] : m_game->assets().getAnimation(record.name);
+		if (!record.placed) { placeRecord(record, animation); }
+		prepared.spawns.push_back({ i, &animation, record.pos, record.inTileMap });
+	}
+
+	return prepared;
+}
+
+void Scene_Play::placeRecord(LevelStream::Record& record, const Animation& animation) const
+{
+	// static solid tiles filling exactly one grid cell only need a tile id in the tilemap,
+	// anything interactive (Brick, Question, Pole) or oversized stays a full entity
+	record.inTileMap = record.tile && isStaticTile(animation, 4.0) && record.gx == std::floor(record.gx) && record.gy == std::floor(record.gy);
+	record.pos = record.inTileMap ? Vec2() : gridToMidPixel(record.gx, record.gy, animation, 4.0);
+	record.placed = true;
+}
+
+LevelStream::Placement Scene_Play::levelPlacement() const
+{
+	LevelStream::Placement placement;
+	placement.cellWidth = m_gridSize.x;
+	placement.cellHeight = m_gridSize.y;
+	placement.worldHeight = (float)height();
+	placement.scale = 4.0;
+	placement.assetHash = m_game->assets().animationHash();
+	return placement;
+}
+
+bool Scene_Play::compileLevel(const std::string& path) const
+{
+	LevelStream source;
+	if (!source.openText(m_levelPath)) { return false; }
+
+	return source.compile(path, levelPlacement(), [this](LevelStream::Record& record)
+	{
+		placeRecord(record, m_game->assets().getAnimation(record.name));
+	});
+}
+
+void Scene_Play::requestChunk(size_t chunk)
+{
+	auto& streamed = m_chunks[chunk];
+	streamed.pending = std::async(std::launch::async, &Scene_Play::prepareChunk, this, chunk, streamed.records, streamed.parsed);
+}
+
+void Scene_Play::loadChunk(size_t chunk)
+{
+	auto& streamed = m_chunks[chunk];
+	if (!streamed.pending.valid()) { requestChunk(chunk); }
+
+	PreparedChunk prepared = streamed.pending.get();
+	streamed.records = std::move(prepared.records);
+	streamed.parsed = true;
+	streamed.entities.assign(streamed.records.size(), Entity());
+
+	for (auto& spawn : prepared.spawns)
+	{
+		const auto& record = streamed.records[spawn.record];
+		if (spawn.inTileMap)
+		{
+			m_tileMap.set((int)record.gx, (int)record.gy, m_tileMap.registerTile(*spawn.animation, Vec2(4.0, 4.0)));
+			continue;
 		}
-		else if (str == "Dec")
+
+		auto entity = m_entityManager.addEntity(record.tile ? Tag::Tile : Tag::Dec);
+		entity.addComponent<CAnimation>(*spawn.animation, true);
+		entity.addComponent<CTransform>(spawn.pos, 4.0);
+		entity.getComponent<CAnimation>().animation.getSprite().setScale(entity.getComponent<CTransform>().scale.x, entity.getComponent<CTransform>().scale.y);
+
+		if (record.tile)
 		{
-			std::string name;
-			float GX, GY;
-			file >> name >> GX >> GY;
-			auto dec = m_entityManager.addEntity("dec");
-			dec->addComponent<CAnimation>(m_game->assets().getAnimation(name), true);
+			entity.addComponent<CBoundingBox>(spawn.animation->getSize() * 4.0,
+				CollisionLayer::Tile, CollisionLayer::Player | CollisionLayer::Bullet);
+			m_broadphase.insert(entity);
+		}
+		m_renderIndex.insert(entity, spawn.pos, spriteHalfSize(entity), CollisionLayer::All);
+		streamed.entities[spawn.record] = entity;
+	}
+
+	streamed.resident = true;
+	m_residentChunks.push_back(chunk);
+}
 
-			Vec2 mid = gridToMidPixel(GX, GY, dec, 4.0);
+void Scene_Play::evictChunk(size_t chunk)
+{
+	auto& streamed = m_chunks[chunk];
 
-			dec->addComponent<CTransform>(mid, 4.0);
-			dec->getComponent<CAnimation>().animation.getSprite().setScale(dec->getComponent<CTransform>().scale.x, dec->getComponent<CTransform>().scale.y);
+	for (size_t i = 0; i < streamed.records.size(); i++)
+	{
+		auto& record = streamed.records[i];
+		Entity entity = streamed.entities[i];
+		if (record.destroyed) { continue; }
+
+		// a null handle means the record went into the tilemap
+		if (entity == Entity())
+		{
+			m_tileMap.set((int)record.gx, (int)record.gy, 0);
+			continue;
 		}
-		else if (str == "Player")
+
+		// remember what happened to the entity, a broken brick stays broken and a used question block stays used
+		if (!entity.isActive())
 		{
-			file >> m_playerConfig.X >> m_playerConfig.Y >> m_playerConfig.CX >> m_playerConfig.CY >> m_playerConfig.SPEED >>
-				m_playerConfig.JUMP >> m_playerConfig.MAXSPEED >> m_playerConfig.GRAVITY >> m_playerConfig.WEAPON;
+			record.destroyed = true;
+			continue;
 		}
-		else
+		const std::string& name = entity.getComponent<CAnimation>().animation.getName();
+		if (name != record.name)
 		{
-			std::cerr << "Unknown Entity Type " << str << std::endl;
+			record.name = name;
+			record.animation = -1;
+			record.placed = false;
 		}
+		destroyLevelEntity(entity);
 	}
 
-	spawnPlayer();
+	streamed.entities.clear();
+	streamed.resident = false;
+}
+
+void Scene_Play::sStreaming()
+{
+	// the chunks under the camera, which is centered the same way sRender does it
+	float centerX = std::max(width() / 2.0f, m_player.getComponent<CTransform>().pos.x);
+	int first = m_level.chunkOf((centerX - width() / 2.0f) / m_gridSize.x);
+	int last = m_level.chunkOf((centerX + width() / 2.0f) / m_gridSize.x);
+
+	// chunks next to the view have to be resident now, the ones beyond are parsed in the background
+	// so they are usually ready by the time the camera reaches them
+	int prefetchEnd = std::min(last + m_chunkPrefetch, (int)m_chunks.size() - 1);
+	for (int c = std::max(0, first - m_chunkPrefetch); c <= prefetchEnd; c++)
+	{
+		if (m_chunks[c].resident) { continue; }
+
+		if (c >= first - m_chunkKeep && c <= last + m_chunkKeep) { loadChunk(c); }
+		else if (!m_chunks[c].pending.valid()) { requestChunk(c); }
+	}
+
+	// evict chunks well outside the view, the gap to the prefetch range keeps them from thrashing
+	for (size_t i = 0; i < m_residentChunks.size();)
+	{
+		int c = (int)m_residentChunks[i];
+		if (c >= first - m_chunkEvict && c <= last + m_chunkEvict) { i++; continue; }
+
+		evictChunk(c);
+		m_residentChunks[i] = m_residentChunks.back();
+		m_residentChunks.pop_back();
+	}
+
+	// static tiles that came or went are merged into collision rectangles again
+	m_tileMap.mergeColliders();
 }
 
 void Scene_Play::spawnPlayer()
 {
-	m_player = m_entityManager.addEntity("player");
+	m_player = m_entityManager.addEntity(Tag::Player);
 
-	m_player->addComponent<CAnimation>(m_game->assets().getAnimation("Stand"), true);
+	m_player.addComponent<CAnimation>(m_game->assets().getAnimation("Stand"), true);
 
 	Vec2 mid = gridToMidPixel(m_playerConfig.X, m_playerConfig.Y, m_player, 2.5);
 
-	m_player->addComponent<CTransform>(mid, 2.5);
-	m_player->getComponent<CAnimation>().animation.getSprite().setScale(m_player->getComponent<CTransform>().scale.x, m_player->getComponent<CTransform>().scale.y);
-	m_player->addComponent<CBoundingBox>(m_game->assets().getAnimation("Stand").getSize() * 2.5);
-	m_player->addComponent<CGravity>(m_playerConfig.GRAVITY);
-	m_player->addComponent<CState>("air");
-	m_player->addComponent<CInput>();
+	m_player.addComponent<CTransform>(mid, 2.5);
+	m_player.getComponent<CAnimation>().animation.getSprite().setScale(m_player.getComponent<CTransform>().scale.x, m_player.getComponent<CTransform>().scale.y);
+	m_player.addComponent<CBoundingBox>(m_game->assets().getAnimation("Stand").getSize() * 2.5,
+		CollisionLayer::Player, CollisionLayer::Tile);
+	m_player.addComponent<CGravity>(m_playerConfig.GRAVITY);
+	m_player.addComponent<CState>(m_playerStates, Air);
+	m_player.addComponent<CInput>();
+	addBody(m_player);
+}
+
+void Scene_Play::addBody(const Entity& entity)
+{
+	entity.addComponent<CBody>().restPos = entity.getComponent<CTransform>().pos;
+	m_bodies.push_back(entity);
 }
 
-void Scene_Play::spawnBullet(std::shared_ptr<Entity> entity)
+void Scene_Play::wakeBody(const Entity& entity)
+{
+	auto& body = entity.getComponent<CBody>();
+	body.asleep = false;
+	body.restingSteps = 0;
+}
+
+void Scene_Play::spawnBullet(Entity entity)
 {
 	// This should spawn a bullet at the given entity, going in the direction the entity is facing
-	const auto& transform = m_player->getComponent<CTransform>();
-	auto bullet = m_entityManager.addEntity("bullet");
+	// add the bullet first: adding an entity may grow the component arrays and move the player's transform
+	auto bullet = m_entityManager.addEntity(Tag::Bullet);
+	const auto& transform = m_player.getComponent<CTransform>();
 
-	bullet->addComponent<CAnimation>(m_game->assets().getAnimation(m_playerConfig.WEAPON), true);
-	bullet->addComponent<CBoundingBox>(m_game->assets().getAnimation(m_playerConfig.WEAPON).getSize() * 4.0);
-	bullet->addComponent<CLifespan>(100, m_currentFrame);
+	bullet.addComponent<CAnimation>(m_game->assets().getAnimation(m_playerConfig.WEAPON), true);
+	bullet.addComponent<CBoundingBox>(m_game->assets().getAnimation(m_playerConfig.WEAPON).getSize() * 4.0,
+		CollisionLayer::Bullet, CollisionLayer::Tile);
+	bullet.addComponent<CLifespan>(100, m_currentFrame);
 
 	if (transform.pos.x - transform.prevPos.x >= 0)
 	{
-		bullet->addComponent<CTransform>(transform.pos, Vec2(10.0, 0.0), 0.0, 4.0);
+		bullet.addComponent<CTransform>(transform.pos, Vec2(10.0, 0.0), 0.0, 4.0);
 	}
 	else
 	{
-		bullet->addComponent<CTransform>(transform.pos, Vec2(-10.0, 0.0), 0.0, 4.0);
+		bullet.addComponent<CTransform>(transform.pos, Vec2(-10.0, 0.0), 0.0, 4.0);
 	}
-	bullet->getComponent<CAnimation>().animation.getSprite().setScale(bullet->getComponent<CTransform>().scale.x, bullet->getComponent<CTransform>().scale.y);
+	bullet.getComponent<CAnimation>().animation.getSprite().setScale(bullet.getComponent<CTransform>().scale.x, bullet.getComponent<CTransform>().scale.y);
+	addBody(bullet);
 }
 
 void Scene_Play::update()
 {
-	m_entityManager.update();
-
 	// TODO: implement pause functionality
 
-	sMovement();
-	sLifespan();
-	sCollision();
-	sAnimation();
-	sRender();
+	// the systems added in buildSystems, spread over the engine's worker threads
+	m_systems.run(m_game->jobs());
 }
 
 void Scene_Play::sMovement()
 {
-	Vec2 playerVelocity(m_player->getComponent<CTransform>().velocity.x, m_player->getComponent<CTransform>().velocity.y);
+	Vec2 playerVelocity(m_player.getComponent<CTransform>().velocity.x, m_player.getComponent<CTransform>().velocity.y);
 
-	if (m_player->getComponent<CInput>().up)
+	if (m_player.getComponent<CInput>().up)
 	{
-		m_player->getComponent<CState>().state = "air";
+		m_playerStates.trigger(m_player.getComponent<CState>(), Jump);
 		playerVelocity.y = m_playerConfig.JUMP;
-		m_player->getComponent<CInput>().up = false;
+		m_player.getComponent<CInput>().up = false;
 	}
 
-	if (m_player->getComponent<CInput>().left)
+	if (m_player.getComponent<CInput>().left)
 	{
-		if (m_player->getComponent<CAnimation>().animation.getName() == "Stand")
-		{
-			m_player->getComponent<CState>().state = "run";
-		}
+		m_playerStates.trigger(m_player.getComponent<CState>(), Move);
 		playerVelocity.x = -5;
 	}
-	else if (m_player->getComponent<CInput>().right)
+	else if (m_player.getComponent<CInput>().right)
 	{
-		if (m_player->getComponent<CAnimation>().animation.getName() == "Stand")
-		{
-			m_player->getComponent<CState>().state = "run";
-		}
+		m_playerStates.trigger(m_player.getComponent<CState>(), Move);
 		playerVelocity.x = 5;
 	}
 	else
@@ -193,51 +419,67 @@ void Scene_Play::sMovement()
 		playerVelocity.x = 0;
 	}
 
-	m_player->getComponent<CTransform>().velocity = playerVelocity;
+	m_player.getComponent<CTransform>().velocity = playerVelocity;
 
-	for (auto& e : m_entityManager.getEntities())
+	// only bodies move, tiles and decorations are static and cost nothing here
+	// handles go stale once the entity manager releases a destroyed body, which drops it from the list
+	m_bodies.erase(std::remove_if(m_bodies.begin(), m_bodies.end(), [](const Entity& e) { return !e.isValid(); }), m_bodies.end());
+
+	auto& transforms = m_entityManager.getComponents<CTransform>();
+	auto& gravities = m_entityManager.getComponents<CGravity>();
+	auto& bodies = m_entityManager.getComponents<CBody>();
+
+	// every body only touches its own slot, so a long list is split across the worker threads
+	m_game->jobs().parallelFor(m_bodies.size(), 2048, [&](size_t begin, size_t end)
 	{
-		if (e->hasComponent<CGravity>())
+		for (size_t b = begin; b < end; b++)
 		{
-			Vec2& velocity = m_player->getComponent<CTransform>().velocity;
-			velocity.y += m_player->getComponent<CGravity>().gravity;
+			const size_t i = m_bodies[b].index();
+			if (!updateRest(bodies[i], transforms[i])) { continue; }
 
-			// if the player is moving faster than max speed in any direction,
-			// set its speed in that direction to the max speed
-			//std::cout << velocity.x << std::endl;
-			if (abs(velocity.x) > m_playerConfig.MAXSPEED)
+			if (gravities[i].has)
 			{
-				if (velocity.x > 0)
+				Vec2& velocity = transforms[i].velocity;
+				velocity.y += gravities[i].gravity;
+
+				// if the player is moving faster than max speed in any direction,
+				// set its speed in that direction to the max speed
+				//std::cout << velocity.x << std::endl;
+				if (abs(velocity.x) > m_playerConfig.MAXSPEED)
 				{
-					velocity.x = m_playerConfig.MAXSPEED;
+					if (velocity.x > 0)
+					{
+						velocity.x = m_playerConfig.MAXSPEED;
+					}
+					else if (velocity.x < 0)
+					{
+						velocity.x = -m_playerConfig.MAXSPEED;
+					}
 				}
-				else if (velocity.x < 0)
+				if (abs(velocity.y) > m_playerConfig.MAXSPEED)
 				{
-					velocity.x = -m_playerConfig.MAXSPEED;
+					if (velocity.y > 0)
+					{
+						velocity.y = m_playerConfig.MAXSPEED;
+					}
+					else if (velocity.y < 0)
+					{
+						velocity.x = -m_playerConfig.MAXSPEED;
+					}
 				}
 			}
-			if (abs(velocity.y) > m_playerConfig.MAXSPEED)
+			if (transforms[i].has)
 			{
-				if (velocity.y > 0)
+				auto& transform = transforms[i];
+				if (transform.velocity.x != 0)
 				{
-					velocity.y = m_playerConfig.MAXSPEED;
+					transform.prevPos.x = transform.pos.x;
 				}
-				else if (velocity.y < 0)
-				{
-					velocity.x = -m_playerConfig.MAXSPEED;
-				}
-			}
-		}
-		if (e->hasComponent<CTransform>())
-		{
-			if (e->getComponent<CTransform>().velocity.x != 0)
-			{
-				e->getComponent<CTransform>().prevPos.x = e->getComponent<CTransform>().pos.x;
+				transform.prevPos.y = transform.pos.y;
+				transform.pos += transform.velocity;
 			}
-			e->getComponent<CTransform>().prevPos.y = e->getComponent<CTransform>().pos.y;
-			e->getComponent<CTransform>().pos += e->getComponent<CTransform>().velocity;
 		}
-	}
+	});
 
 	// TODO: Implement player movement / jumping based on its CInput component
 	// TODO: Implement gravity's effect on the player
@@ -245,18 +487,124 @@ void Scene_Play::sMovement()
 	// NOTE: Setting an entity's scale.x to -1/1 will make it face to the left/right
 }
 
+// counts the steps a body ended where it started and puts it to sleep after a while, returns false while it sleeps
+// a resting body under gravity falls into the ground and is pushed back out every step, so sleeping skips that work
+// without changing anything: it wakes as soon as it has velocity, and input and contacts wake it too
+bool Scene_Play::updateRest(CBody& body, const CTransform& transform) const
+{
+	const size_t stepsToSleep = 30;
+
+	if (transform.velocity.x != 0 || transform.velocity.y != 0 || transform.pos != body.restPos)
+	{
+		body.asleep = false;
+		body.restingSteps = 0;
+	}
+	else if (!body.asleep && ++body.restingSteps >= stepsToSleep)
+	{
+		body.asleep = true;
+	}
+
+	body.restPos = transform.pos;
+	return !body.asleep;
+}
+
 void Scene_Play::sLifespan()
 {
 	// TODO: Check lifespan of entities that have them, and destroy them if they go over
-	for (auto& e : m_entityManager.getEntities("bullet"))
+	auto& lifespans = m_entityManager.getComponents<CLifespan>();
+	for (size_t i = 0; i < lifespans.size(); i++)
+	{
+		if (lifespans[i].has && m_currentFrame - lifespans[i].frameCreated >= lifespans[i].lifespan)
+		{
+			m_entityManager.entityAt(i).destroy();
+		}
+	}
+}
+
+// collects everything the given box could collide with on the layers in mask:
+// entity tiles from the broadphase, then solid cells straight out of the tilemap
+void Scene_Play::gatherColliders(const Vec2& pos, const Vec2& halfSize, unsigned mask, std::vector<Collider>& out)
+{
+	out.clear();
+	m_colliderBoxes.clear();
+
+	m_broadphase.query(pos, halfSize, mask, m_collisionCandidates);
+	for (auto& e : m_collisionCandidates)
+	{
+		out.push_back({ e.getComponent<CTransform>().pos, e.getComponent<CBoundingBox>().halfSize, e });
+		m_colliderBoxes.push_back(out.back().pos, out.back().halfSize);
+	}
+
+	if (mask & CollisionLayer::Tile)
 	{
-		if (m_currentFrame - e->getComponent<CLifespan>().frameCreated >= e->getComponent<CLifespan>().lifespan)
+		m_tileMap.query(pos, halfSize, m_tileBoxes);
+		for (auto& box : m_tileBoxes)
 		{
-			e->destroy();
+			out.push_back({ box.pos, box.halfSize, Entity() });
+			m_colliderBoxes.push_back(box.pos, box.halfSize);
 		}
 	}
 }
 
+// an entity that moves more than its half size in one step can pass through a collider, or sink in so deep that
+// the discrete resolution pushes it out the wrong way, so it is moved back along its path to where it first
+// touches something, slides along that surface for the rest of the step, and ends just inside it, where the
+// discrete resolution in sCollision then handles the contact as usual
+void Scene_Play::sweepFastMover(const Entity& entity)
+{
+	auto& transform = entity.getComponent<CTransform>();
+	const auto& box = entity.getComponent<CBoundingBox>();
+	const Vec2& motion = transform.velocity;
+	if (std::abs(motion.x) <= box.halfSize.x && std::abs(motion.y) <= box.halfSize.y) { return; }
+
+	// everything the box could touch on its way
+	const Vec2 start = transform.pos - motion;
+	const Vec2 sweptHalf(box.halfSize.x + std::abs(motion.x) / 2, box.halfSize.y + std::abs(motion.y) / 2);
+	gatherColliders(start + motion / 2, sweptHalf, box.mask, m_colliders);
+
+	Physics::SweepHit hit;
+	if (!Physics::SweepFirst(start, box.halfSize, motion, m_colliderBoxes, hit)) { return; }
+
+	// the motion left after the contact still happens along the surface, so landing while running keeps the run
+	// and the path does not depend on the step length; the slide starts a skin outside the surface, so the next
+	// box along it (a neighbouring brick) is not hit edge on
+	const float contactDepth = 0.25f;
+	const float skin = 0.01f;
+	const Vec2 contact = start + motion * hit.time + hit.normal * skin;
+	Vec2 slide = motion * (1 - hit.time);
+	if (hit.normal.x != 0)	{ slide.x = 0; }
+	else					{ slide.y = 0; }
+
+	// the slide stays inside the swept box, so the colliders gathered above cover it
+	Physics::SweepHit slideHit;
+	Vec2 end = contact + slide;
+	if (Physics::SweepFirst(contact, box.halfSize, slide, m_colliderBoxes, slideHit))
+	{
+		end = contact + slide * slideHit.time - slideHit.normal * contactDepth;
+	}
+
+	transform.pos = end - hit.normal * (contactDepth + skin);
+}
+
+void Scene_Play::destroyLevelEntity(const Entity& entity)
+{
+	// a body resting on or against the entity has to wake up, or it would float where the entity was
+	const Vec2& pos = entity.getComponent<CTransform>().pos;
+	const Vec2 reach = entity.getComponent<CBoundingBox>().halfSize + Vec2(1, 1);
+	for (auto& body : m_bodies)
+	{
+		if (!body.isActive() || !body.getComponent<CBody>().asleep) { continue; }
+
+		Vec2 overlap = Physics::GetOverlap(pos, reach, body.getComponent<CTransform>().pos, body.getComponent<CBoundingBox>().halfSize);
+		if (overlap.x >= 0 && overlap.y >= 0) { wakeBody(body); }
+	}
+
+	// a destroyed tile or decoration has to leave both indices, its slot may be reused by the next entity
+	m_broadphase.remove(entity);
+	m_renderIndex.remove(entity, entity.getComponent<CTransform>().pos, spriteHalfSize(entity));
+	entity.destroy();
+}
+
 void Scene_Play::sCollision()
 {
 	// REMEMBER: SFML's (0,0) position is on the TOP-LEFT corner
@@ -266,84 +614,124 @@ void Scene_Play::sCollision()
 	//			 Also, something ABOVE something else will have a y value LESS than it
 
 	// TODO: Implement Physics::GetOverlap() function, use it inside this function
-	for (auto& t : m_entityManager.getEntities("tile"))
+	// only the entity tiles in the cells the player touches and the tilemap cells under it are tested
+	sweepFastMover(m_player);
+	gatherColliders(m_player.getComponent<CTransform>().pos, m_player.getComponent<CBoundingBox>().halfSize,
+		m_player.getComponent<CBoundingBox>().mask, m_colliders);
+
+	Vec2 testedPos = m_player.getComponent<CTransform>().pos;
+	Physics::GetOverlaps(testedPos, m_player.getComponent<CBoundingBox>().halfSize, m_colliderBoxes, m_overlaps);
+
+	for (size_t i = 0; i < m_colliders.size(); i++)
 	{
-		Vec2 overlap = Physics::GetOverlap(t, m_player);
-		if (overlap.x > 0 && overlap.y > 0)
+		// resolving a collision moves the player, the colliders after it are tested again from the new position
+		if (m_player.getComponent<CTransform>().pos != testedPos)
+		{
+			testedPos = m_player.getComponent<CTransform>().pos;
+			Physics::GetOverlaps(testedPos, m_player.getComponent<CBoundingBox>().halfSize, m_colliderBoxes, m_overlaps);
+		}
+
+		auto& c = m_colliders[i];
+		Vec2 overlap = m_overlaps[i];
+		if (m_overlaps.hit(i))
 		{
-			if (t->getComponent<CAnimation>().animation.getName() == "Pole" || t->getComponent<CAnimation>().animation.getName() == "PoleTop")
+			if (c.entity && (c.entity.getComponent<CAnimation>().animation.getName() == "Pole" || c.entity.getComponent<CAnimation>().animation.getName() == "PoleTop"))
 			{
-				m_player->destroy();
+				m_player.destroy();
 				spawnPlayer();
 			}
 
-			Vec2 prevOverlap = Physics::GetPreviousOverlap(t, m_player);
+			Vec2 prevOverlap = Physics::GetOverlap(c.pos, c.halfSize, m_player.getComponent<CTransform>().prevPos, m_player.getComponent<CBoundingBox>().halfSize);
 
 			if (prevOverlap.y <= 0)
 			{
-				if (m_player->getComponent<CTransform>().velocity.y > 0)
+				if (m_player.getComponent<CTransform>().velocity.y > 0)
 				{
-					m_player->getComponent<CTransform>().pos.y -= overlap.y;
-					m_player->getComponent<CTransform>().velocity.y = 0;
-					if (m_player->getComponent<CTransform>().velocity.x == 0)
+					m_player.getComponent<CTransform>().pos.y -= overlap.y;
+					m_player.getComponent<CTransform>().velocity.y = 0;
+					if (m_player.getComponent<CTransform>().velocity.x == 0)
 					{
-					m_player->getComponent<CState>().state = "stand";
+						m_playerStates.trigger(m_player.getComponent<CState>(), LandStill);
 					}
-					else { m_player->getComponent<CState>().state = "run"; }
-					m_player->getComponent<CInput>().canJump = true;
+					else { m_playerStates.trigger(m_player.getComponent<CState>(), LandMoving); }
+					m_player.getComponent<CInput>().canJump = true;
 				}
 				else
 				{
-					m_player->getComponent<CTransform>().pos.y += overlap.y;
-					m_player->getComponent<CTransform>().velocity.y = 0;
-					if (t->getComponent<CAnimation>().animation.getName() == "Brick") {
-						t->destroy();
+					m_player.getComponent<CTransform>().pos.y += overlap.y;
+					m_player.getComponent<CTransform>().velocity.y = 0;
+					if (!c.entity) { continue; }
+
+					if (c.entity.getComponent<CAnimation>().animation.getName() == "Brick") {
+						destroyLevelEntity(c.entity);
 					}
-					else if (t->getComponent<CAnimation>().animation.getName() == "Question")
+					else if (c.entity.getComponent<CAnimation>().animation.getName() == "Question")
 					{
-						t->addComponent<CAnimation>(m_game->assets().getAnimation("Question2"), true);
-						t->getComponent<CAnimation>().animation.getSprite().setScale(t->getComponent<CTransform>().scale.x, t->getComponent<CTransform>().scale.y);
+						c.entity.addComponent<CAnimation>(m_game->assets().getAnimation("Question2"), true);
+						c.entity.getComponent<CAnimation>().animation.getSprite().setScale(c.entity.getComponent<CTransform>().scale.x, c.entity.getComponent<CTransform>().scale.y);
 					}
 				}
 			}
 		}
 	}
 
-	for (auto& t : m_entityManager.getEntities("tile"))
+	// TODO: Implement bullet / tile collisions
+	//		 Destroy the tile if it has a Brick animation
+	for (auto& b : m_entityManager.getEntities(Tag::Bullet))
 	{
-		// TODO: Implement bullet / tile collisions
-		//		 Destroy the tile if it has a Brick animation
-		for (auto& b : m_entityManager.getEntities("bullet"))
+		sweepFastMover(b);
+		gatherColliders(b.getComponent<CTransform>().pos, b.getComponent<CBoundingBox>().halfSize,
+			b.getComponent<CBoundingBox>().mask, m_colliders);
+		Physics::GetOverlaps(b.getComponent<CTransform>().pos, b.getComponent<CBoundingBox>().halfSize, m_colliderBoxes, m_overlaps);
+
+		for (size_t i = 0; i < m_colliders.size(); i++)
 		{
-			Vec2 overlap = Physics::GetOverlap(t, b);
-			if (overlap.x > 0 && overlap.y > 0)
+			auto& c = m_colliders[i];
+			if (m_overlaps.hit(i))
 			{
-				b->destroy();
-				if (t->getComponent<CAnimation>().animation.getName() == "Brick")
+				b.destroy();
+				if (c.entity && c.entity.getComponent<CAnimation>().animation.getName() == "Brick")
 				{
-					t->destroy();
+					destroyLevelEntity(c.entity);
 				}
 			}
 		}
+	}
+
+	// the vertical resolution above may have moved (or respawned) the player, so query again
+	gatherColliders(m_player.getComponent<CTransform>().pos, m_player.getComponent<CBoundingBox>().halfSize,
+		m_player.getComponent<CBoundingBox>().mask, m_colliders);
 
+	testedPos = m_player.getComponent<CTransform>().pos;
+	Physics::GetOverlaps(testedPos, m_player.getComponent<CBoundingBox>().halfSize, m_colliderBoxes, m_overlaps);
+
+	for (size_t i = 0; i < m_colliders.size(); i++)
+	{
 		// TODO: Implement player / tile collisions and resolutions
 		//		 Update the CState component of the player to store whether
 		//		 it is currently on the ground or in the air. This will be
 		//		 used by the Animation system
-		Vec2 overlap = Physics::GetOverlap(t, m_player);
-		if (overlap.x > 0 && overlap.y > 0)
+		if (m_player.getComponent<CTransform>().pos != testedPos)
+		{
+			testedPos = m_player.getComponent<CTransform>().pos;
+			Physics::GetOverlaps(testedPos, m_player.getComponent<CBoundingBox>().halfSize, m_colliderBoxes, m_overlaps);
+		}
+
+		auto& c = m_colliders[i];
+		Vec2 overlap = m_overlaps[i];
+		if (m_overlaps.hit(i))
 		{
-			Vec2 prevOverlap = Physics::GetPreviousOverlap(t, m_player);
+			Vec2 prevOverlap = Physics::GetOverlap(c.pos, c.halfSize, m_player.getComponent<CTransform>().prevPos, m_player.getComponent<CBoundingBox>().halfSize);
 
 			if (prevOverlap.x <= 0)
 			{
-				if (m_player->getComponent<CTransform>().velocity.x < 0)
+				if (m_player.getComponent<CTransform>().velocity.x < 0)
 				{
-					m_player->getComponent<CTransform>().pos.x += overlap.x;
+					m_player.getComponent<CTransform>().pos.x += overlap.x;
 				}
-				else if (m_player->getComponent<CTransform>().velocity.x > 0)
+				else if (m_player.getComponent<CTransform>().velocity.x > 0)
 				{
-					m_player->getComponent<CTransform>().pos.x -= overlap.x;
+					m_player.getComponent<CTransform>().pos.x -= overlap.x;
 				}
 			}
 		}
@@ -352,111 +740,119 @@ void Scene_Play::sCollision()
 	// TODO: Check to see if the player has fallen down a hole ( y > height())
 	// TODO: Don't let the player walk of the left side of the map
 
-	if (m_player->getComponent<CTransform>().pos.y > m_game->window().getSize().y)
+	if (m_player.getComponent<CTransform>().pos.y > height())
 	{
-		m_player->destroy();
+		m_player.destroy();
 		spawnPlayer();
 	}
-	if (m_player->getComponent<CTransform>().pos.x < m_player->getComponent<CBoundingBox>().halfSize.x)
+	if (m_player.getComponent<CTransform>().pos.x < m_player.getComponent<CBoundingBox>().halfSize.x)
 	{
-		m_player->getComponent<CTransform>().pos.x -= m_player->getComponent<CTransform>().velocity.x;
+		m_player.getComponent<CTransform>().pos.x -= m_player.getComponent<CTransform>().velocity.x;
 	}
 }
 
 void Scene_Play::sDoAction(const Action& action)
 {
-	if (action.type() == "START")
-	{
-		if		(action.name() == "TOGGLE_TEXTURE")		{ m_drawTextures = !m_drawTextures; }
-		else if (action.name() == "TOGGLE_COLLISION")	{ m_drawCollision = !m_drawCollision; }
-		else if (action.name() == "TOGGLE_GRID")		{ m_drawGrid = !m_drawGrid; }
-		else if (action.name() == "PAUSE")				{ setPaused(!m_paused); }
-		else if (action.name() == "QUIT")				{ onEnd(); }
-		else if (action.name() == "JUMP")
-		{
-			if (m_player->getComponent<CInput>().canJump)
-			{
-				m_player->getComponent<CInput>().up = true;
-				m_player->getComponent<CInput>().canJump = false;
-			}
-		}
-
-		else if (action.name() == "LEFT")
-		{
-			m_player->getComponent<CInput>().left = true;
-		}
-		else if (action.name() == "RIGHT")
-		{
-			m_player->getComponent<CInput>().right = true;
-		}
+	// the action ids are dense, so this compiles to a jump table instead of a chain of compares
+	const bool start = action.type() == ActionType::Start;
+	if (!start && action.type() != ActionType::End) { return; }
 
-		else if (action.name() == "SHOOT")
-		{
-			if (m_player->getComponent<CInput>().canShoot)
-			{
-				spawnBullet(m_player);
-				m_player->getComponent<CInput>().canShoot = false;
-			}
-		}
-	}
-	else if (action.type() == "END")
+	switch (action.id())
 	{
-		if (action.name() == "JUMP")
+	case ActionName::ToggleTexture:		if (start) { m_drawTextures = !m_drawTextures; }	break;
+	case ActionName::ToggleCollision:	if (start) { m_drawCollision = !m_drawCollision; }	break;
+	case ActionName::ToggleGrid:		if (start) { m_drawGrid = !m_drawGrid; }			break;
+	case ActionName::Pause:				if (start) { setPaused(!m_paused); }				break;
+	case ActionName::Quit:				if (start) { onEnd(); }								break;
+
+	case ActionName::Jump:
+		// any movement input wakes the player up, the movement system then sees its velocity
+		wakeBody(m_player);
+		if (start)
 		{
-			if (m_player->getComponent<CTransform>().velocity.y < 0)
+			if (m_player.getComponent<CInput>().canJump)
 			{
-				m_player->getComponent<CTransform>().velocity.y = 0;
+				m_player.getComponent<CInput>().up = true;
+				m_player.getComponent<CInput>().canJump = false;
 			}
 		}
-		else if (action.name() == "LEFT")
+		else if (m_player.getComponent<CTransform>().velocity.y < 0)
 		{
-			m_player->getComponent<CInput>().left = false;
+			m_player.getComponent<CTransform>().velocity.y = 0;
 		}
-		else if (action.name() == "RIGHT")
+		break;
+
+	case ActionName::Left:
+		wakeBody(m_player);
+		m_player.getComponent<CInput>().left = start;
+		break;
+
+	case ActionName::Right:
+		wakeBody(m_player);
+		m_player.getComponent<CInput>().right = start;
+		break;
+
+	case ActionName::Shoot:
+		if (!start)
 		{
-			m_player->getComponent<CInput>().right = false;
+			m_player.getComponent<CInput>().canShoot = true;
 		}
-
-		else if (action.name() == "SHOOT")
+		else if (m_player.getComponent<CInput>().canShoot)
 		{
-			m_player->getComponent<CInput>().canShoot = true;
+			spawnBullet(m_player);
+			m_player.getComponent<CInput>().canShoot = false;
 		}
+		break;
 	}
 }
 
 void Scene_Play::sAnimation()
 {
 	// TODO: Complete the Animation class code first
-	if (m_player->getComponent<CState>().state == "stand" && m_player->getComponent<CAnimation>().animation.getName() != "Stand")
-	{
-		m_player->addComponent<CAnimation>(m_game->assets().getAnimation("Stand"), true);
-	}
-
-	if (m_player->getComponent<CState>().state == "air" && m_player->getComponent<CAnimation>().animation.getName() != "Air")
+	// any entity whose state changed switches to the animation its state graph resolved at load
+	auto& states = m_entityManager.getComponents<CState>();
+	for (size_t i = 0; i < states.size(); i++)
 	{
-		m_player->addComponent<CAnimation>(m_game->assets().getAnimation("Air"), true);
-	}
-
-	if (m_player->getComponent<CState>().state == "run" && m_player->getComponent<CAnimation>().animation.getName() != "Run")
-	{
-		m_player->addComponent<CAnimation>(m_game->assets().getAnimation("Run"), true);
+		if (states[i].has && states[i].changed)
+		{
+			m_entityManager.entityAt(i).addComponent<CAnimation>(states[i].graph->animation(states[i].state), true);
+			states[i].changed = false;
+		}
 	}
-	m_player->getComponent<CAnimation>().animation.getSprite().setScale(m_player->getComponent<CTransform>().scale.x, m_player->getComponent<CTransform>().scale.y);
+	m_player.getComponent<CAnimation>().animation.getSprite().setScale(m_player.getComponent<CTransform>().scale.x, m_player.getComponent<CTransform>().scale.y);
 	
-	if (m_player->getComponent<CTransform>().pos.x - m_player->getComponent<CTransform>().prevPos.x < 0)
+	if (m_player.getComponent<CTransform>().pos.x - m_player.getComponent<CTransform>().prevPos.x < 0)
 	{
-		m_player->getComponent<CAnimation>().animation.getSprite().scale(-1.f, 1.f);
+		m_player.getComponent<CAnimation>().animation.getSprite().scale(-1.f, 1.f);
 	}
 	// TODO: set the animation of the player based on its CState component
 	// TODO: for each entity with an animation, call entitiy->getComponent<CAnimation>().animation.update()
 	//		 if the animation is not repeated, and it has ended, destroy the entity
-	for (auto& e : m_entityManager.getEntities())
+	// each animation only advances itself, so large scenes split the entities across the worker threads
+	auto& entities = m_entityManager.getEntities();
+	m_game->jobs().parallelFor(entities.size(), 1024, [&](size_t begin, size_t end)
 	{
-		if (e->hasComponent<CAnimation>())
+		for (size_t i = begin; i < end; i++)
 		{
-			e->getComponent<CAnimation>().animation.update();
+			if (entities[i].hasComponent<CAnimation>())
+			{
+				entities[i].getComponent<CAnimation>().animation.update();
+			}
 		}
+	});
+}
+
+std::string Scene_Play::summary()
+{
+	// full float precision, so any difference in the player's path shows up
+	std::ostringstream out;
+	out << std::setprecision(9) << Scene::summary();
+	if (m_player.isActive())
+	{
+		const Vec2& pos = m_player.getComponent<CTransform>().pos;
+		out << ", player at (" << pos.x << ", " << pos.y << ")";
 	}
+	return out.str();
 }
 
 void Scene_Play::onEnd()
@@ -472,6 +868,59 @@ void Scene_Play::drawLine(const Vec2& p1, const Vec2& p2)
 	m_game->window().draw(line, 2, sf::Lines);
 }
 
+Vec2 Scene_Play::spriteHalfSize(const Entity& entity) const
+{
+	auto& scale = entity.getComponent<CTransform>().scale;
+	auto& size = entity.getComponent<CAnimation>().animation.getSize();
+	return Vec2(std::abs(size.x * scale.x), std::abs(size.y * scale.y)) / 2;
+}
+
+void Scene_Play::cullEntities(const sf::FloatRect& area)
+{
+	Vec2 halfSize(area.width / 2, area.height / 2);
+	Vec2 center(area.left + halfSize.x, area.top + halfSize.y);
+
+	// tiles and decorations never move, so they come straight out of the render index
+	m_renderIndex.query(center, halfSize, CollisionLayer::All, m_visibleEntities);
+	size_t total = m_entityManager.getEntities(Tag::Tile).size() + m_entityManager.getEntities(Tag::Dec).size();
+
+	// the few moving entities are tested against the view directly
+	for (EntityTag tag = 0; tag < m_entityManager.tagCount(); tag++)
+	{
+		if (tag == Tag::Tile || tag == Tag::Dec) { continue; }
+
+		for (auto& e : m_entityManager.getEntities(tag))
+		{
+			if (!e.isActive() || !e.hasComponent<CAnimation>()) { continue; }
+			total++;
+
+			Vec2 overlap = Physics::GetOverlap(center, halfSize, e.getComponent<CTransform>().pos, spriteHalfSize(e));
+			if (overlap.x > 0 && overlap.y > 0)
+			{
+				m_visibleEntities.push_back(e);
+			}
+		}
+	}
+
+	m_visibleCount = m_visibleEntities.size();
+	m_culledCount = total - m_visibleCount;
+}
+
+void Scene_Play::appendBox(const Vec2& pos, const Vec2& halfSize)
+{
+	// the same outline a 1px RectangleShape of size - 1 would draw, as four line segments
+	sf::Vector2f tl(pos.x - halfSize.x, pos.y - halfSize.y);
+	sf::Vector2f br(pos.x + halfSize.x - 1, pos.y + halfSize.y - 1);
+	sf::Vector2f tr(br.x, tl.y);
+	sf::Vector2f bl(tl.x, br.y);
+
+	sf::Vector2f corners[] = { tl, tr, tr, br, br, bl, bl, tl };
+	for (auto& corner : corners)
+	{
+		m_collisionLines.append(sf::Vertex(corner, sf::Color(255, 255, 255, 255)));
+	}
+}
+
 void Scene_Play::sRender()
 {
 	// color the background darker so you know the game is paused
@@ -479,48 +928,55 @@ void Scene_Play::sRender()
 	else { m_game->window().clear(sf::Color(50, 50, 150)); }
 
 	// set the viewport of the window to be centered on the player if it's far enough right
-	auto& pPos = m_player->getComponent<CTransform>().pos;
+	auto& pPos = m_player.getComponent<CTransform>().pos;
 	float windowCenterX = std::max(m_game->window().getSize().x / 2.0f, pPos.x);
 	sf::View view = m_game->window().getView();
 	view.setCenter(windowCenterX, m_game->window().getSize().y - view.getCenter().y);
 	m_game->window().setView(view);
 
-	// draw all Entity textures / animations
+	// the part of the world currently on screen, nothing outside it is drawn
+	sf::FloatRect viewArea(view.getCenter().x - view.getSize().x / 2, view.getCenter().y - view.getSize().y / 2, view.getSize().x, view.getSize().y);
+	cullEntities(viewArea);
+
+	// draw all visible Entity textures / animations
+	// sprites are batched into one vertex array per texture, so this is a few draw calls in total
 	if (m_drawTextures)
 	{
-		for (auto& e : m_entityManager.getEntities())
-		{
-			auto& transform = e->getComponent<CTransform>();
+		m_spriteBatch.begin();
+		size_t tilesDrawn = m_tileMap.render(m_spriteBatch, viewArea);
+		m_visibleCount += tilesDrawn;
+		m_culledCount += m_tileMap.tileCount() - tilesDrawn;
 
-			if (e->hasComponent<CAnimation>())
-			{
-				auto& animation = e->getComponent<CAnimation>().animation;
-				animation.getSprite().setRotation(transform.angle);
-				animation.getSprite().setPosition(transform.pos.x, transform.pos.y);
-				m_game->window().draw(animation.getSprite());
-			}
+		for (auto& e : m_visibleEntities)
+		{
+			auto& transform = e.getComponent<CTransform>();
+			m_spriteBatch.draw(e.getComponent<CAnimation>().animation.getSprite(), transform.pos, transform.angle);
 		}
+
+		m_spriteBatch.end(m_game->window());
 	}
 
-	// draw all Entity collision bounding boxes with a rectangleshape
+	// draw the visible collision bounding boxes as one array of lines
 	if (m_drawCollision)
 	{
-		for (auto& e : m_entityManager.getEntities())
+		m_collisionLines.clear();
+
+		Vec2 halfSize(viewArea.width / 2, viewArea.height / 2);
+		m_tileMap.query(Vec2(viewArea.left + halfSize.x, viewArea.top + halfSize.y), halfSize, m_tileBoxes);
+		for (auto& box : m_tileBoxes)
+		{
+			appendBox(box.pos, box.halfSize);
+		}
+
+		for (auto& e : m_visibleEntities)
 		{
-			if (e->hasComponent<CBoundingBox>())
+			if (e.hasComponent<CBoundingBox>())
 			{
-				auto& box = e->getComponent<CBoundingBox>();
-				auto& transform = e->getComponent <CTransform>();
-				sf::RectangleShape rect;
-				rect.setSize(sf::Vector2f(box.size.x - 1, box.size.y - 1));
-				rect.setOrigin(sf::Vector2f(box.halfSize.x, box.halfSize.y));
-				rect.setPosition(transform.pos.x, transform.pos.y);
-				rect.setFillColor(sf::Color(0, 0, 0, 0));
-				rect.setOutlineColor(sf::Color(255, 255, 255, 255));
-				rect.setOutlineThickness(1);
-				m_game->window().draw(rect);
+				appendBox(e.getComponent<CTransform>().pos, e.getComponent<CBoundingBox>().halfSize);
 			}
 		}
+
+		m_game->window().draw(m_collisionLines);
 	}
 
 	// draw the grid so that students can easily debug
@@ -528,25 +984,41 @@ void Scene_Play::sRender()
 	{
 		float leftX = m_game->window().getView().getCenter().x - width() / 2;
 		float rightX = leftX + width() + m_gridSize.x;
-		float nextGridX = leftX - ((int)leftX % (int)m_gridSize.x);
+		float nextGridX = std::floor(leftX / m_gridSize.x) * m_gridSize.x;
 
 		for (float x = nextGridX; x < rightX; x += m_gridSize.x)
 		{
 			drawLine(Vec2(x, 0), Vec2(x, height()));
 		}
 
+		// grid labels keep their glyphs between frames, a label slot only changes when a new column scrolls into it
+		const int columns = (int)(width() / m_gridSize.x) + 3;
+		const int rows = (int)(height() / m_gridSize.y) + 1;
+		m_gridText.begin();
+
 		for (float y = 0; y < height(); y += m_gridSize.y)
 		{
 			drawLine(Vec2(leftX, height() - y), Vec2(rightX, height() - y));
 
 			for (float x = nextGridX; x < rightX; x += m_gridSize.x)
 			{
-				std::string xCell = std::to_string((int)x / (int)m_gridSize.x);
-				std::string yCell = std::to_string((int)y / (int)m_gridSize.y);
-				m_gridText.setString("(" + xCell + "," + yCell + ")");
-				m_gridText.setPosition(x + 3, height() - y - m_gridSize.y + 2);
-				m_game->window().draw(m_gridText);
+				int gx = (int)x / (int)m_gridSize.x;
+				int gy = (int)y / (int)m_gridSize.y;
+				size_t slot = (size_t)(((gx % columns) + columns) % columns * rows + gy);
+				sf::Vector2f position(x + 3, height() - y - m_gridSize.y + 2);
+
+				if (!m_gridText.reuse(slot, position))
+				{
+					m_gridText.set(slot, "(" + std::to_string(gx) + "," + std::to_string(gy) + ")", position);
+				}
 			}
 		}
+
+		// sprite batch and culling counters, so the draw call reduction and culling can be checked
+		m_gridText.set((size_t)(columns * rows), "sprites: " + std::to_string(m_spriteBatch.spriteCount()) + "  draw calls: " + std::to_string(m_spriteBatch.drawCalls()) +
+			"  visible: " + std::to_string(m_visibleCount) + "  culled: " + std::to_string(m_culledCount) +
+			"  tile colliders: " + std::to_string(m_tileMap.colliderCount()) + "/" + std::to_string(m_tileMap.tileCount()),
+			sf::Vector2f(viewArea.left + 3, viewArea.top + 3));
+		m_gridText.draw(m_game->window());
 	}
 }
\ No newline at end of file
@@ -5,6 +5,15 @@
 #include <memory>
 
 #include "EntityManager.hpp"
+#include "SpatialHash.hpp"
+#include "TileMap.hpp"
+#include "SpriteBatch.hpp"
+#include "TextBatch.hpp"
+#include "LevelStream.hpp"
+#include "SystemScheduler.hpp"
+#include "Physics.hpp"
+
+#include <future>
 
 class Scene_Play : public Scene
 {
@@ -14,29 +23,112 @@ class Scene_Play : public Scene
 		std::string WEAPON;
 	};
 
+	// states and events of the player's state graph
+	enum PlayerState { Stand, Run, Air, PlayerStateCount };
+	enum PlayerEvent { Jump, Move, LandStill, LandMoving, PlayerEventCount };
+
+	// a box the collision system resolves against, entity is a null handle for merged tilemap colliders
+	struct Collider
+	{
+		Vec2					pos;
+		Vec2					halfSize;
+		Entity					entity;
+	};
+
+	// what one level record turns into, resolved on a worker thread so the main thread only creates entities
+	struct ChunkSpawn
+	{
+		size_t					record;
+		const Animation*		animation;
+		Vec2					pos;
+		bool					inTileMap;		// static single-cell tile, stored as a tilemap id
+	};
+
+	struct PreparedChunk
+	{
+		std::vector<LevelStream::Record>	records;
+		std::vector<ChunkSpawn>				spawns;
+	};
+
+	// runtime state of one level chunk, the records outlive eviction and carry its mutable state
+	struct StreamedChunk
+	{
+		std::vector<LevelStream::Record>	records;
+		bool								parsed = false;
+		bool								resident = false;
+		std::future<PreparedChunk>			pending;
+		std::vector<Entity>					entities;	// entity of each record while resident, null for tilemap cells
+	};
+
 protected:
 
-	std::shared_ptr<Entity>	m_player;
+	Entity					m_player;
 	std::string				m_levelPath;
 	PlayerConfig			m_playerConfig;
+	StateGraph				m_playerStates;
 	bool					m_drawTextures = true;
 	bool					m_drawCollision = false;
 	bool					m_drawGrid = false;
 	const Vec2				m_gridSize = { 64, 64 };
-	sf::Text				m_gridText;
+	SpatialHash				m_broadphase;
+	SpatialHash				m_renderIndex;		// sprite bounds of tiles and decorations, which never move
+	EntityVec				m_collisionCandidates;
+	TileMap					m_tileMap;
+	std::vector<TileMap::Box>	m_tileBoxes;
+	std::vector<Collider>	m_colliders;
+	Physics::Boxes			m_colliderBoxes;	// the boxes of m_colliders for the batch overlap test
+	Physics::Overlaps		m_overlaps;
+	TextBatch				m_gridText;
+	SpriteBatch				m_spriteBatch;
+	LevelStream				m_level;
+	std::vector<const Animation*>	m_levelAnimations;	// resolved animationNames() of a compiled level
+	std::vector<StreamedChunk>	m_chunks;
+	std::vector<size_t>		m_residentChunks;
+	const int				m_chunkKeep = 1;		// chunks beyond the view that must be resident
+	const int				m_chunkPrefetch = 2;	// chunks beyond the view that are parsed in the background
+	const int				m_chunkEvict = 3;		// chunks further away than this are evicted
+	EntityVec				m_visibleEntities;
+	sf::VertexArray			m_collisionLines;
+	size_t					m_visibleCount = 0;
+	size_t					m_culledCount = 0;
+	SystemScheduler			m_systems;
+	EntityVec				m_bodies;			// every entity with a CBody, the only ones sMovement integrates
 
 	void init(const std::string& levelPath);
 
 	void loadLevel(const std::string& filename);
+	void buildStateGraphs();
+	void buildSystems();
+	bool isStaticTile(const Animation& animation, float scale) const;
+	void gatherColliders(const Vec2& pos, const Vec2& halfSize, unsigned mask, std::vector<Collider>& out);
+	void addBody(const Entity& entity);
+	void wakeBody(const Entity& entity);
+	bool updateRest(CBody& body, const CTransform& transform) const;
+	void sweepFastMover(const Entity& entity);
+	void destroyLevelEntity(const Entity& entity);
+	PreparedChunk prepareChunk(size_t chunk, std::vector<LevelStream::Record> records, bool parsed) const;
+	void placeRecord(LevelStream::Record& record, const Animation& animation) const;
+	LevelStream::Placement levelPlacement() const;
+	void requestChunk(size_t chunk);
+	void loadChunk(size_t chunk);
+	void evictChunk(size_t chunk);
+	Vec2 spriteHalfSize(const Entity& entity) const;
+	void cullEntities(const sf::FloatRect& area);
+	void appendBox(const Vec2& pos, const Vec2& halfSize);
 
 public:
 	Scene_Play(GameEngine* gameEngine, const std::string& levelPath);
 
-	Vec2 gridToMidPixel(float gridX, float gridY, std::shared_ptr<Entity> entity, float scale = 1.0);
+	Vec2 gridToMidPixel(float gridX, float gridY, Entity entity, float scale = 1.0);
+	Vec2 gridToMidPixel(float gridX, float gridY, const Animation& animation, float scale = 1.0) const;
+
+	// writes this scene's level as a compiled level (LevelStream::compile) with the current assets and settings
+	bool compileLevel(const std::string& path) const;
 
 	void spawnPlayer();
-	void spawnBullet(std::shared_ptr<Entity> entity);
+	void spawnBullet(Entity entity);
 
+	void sStreaming();
 	void sLifespan();
 	void sMovement();
 	void sCollision();
@@ -45,6 +137,7 @@ public:
 	void sRender();
 
 	void update();
+	std::string summary();
 	void onEnd();
 	void drawLine(const Vec2& p1, const Vec2& p2);
 };
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "SpatialHash.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+SpatialHash::SpatialHash()
+{
+
+}
+
+SpatialHash::SpatialHash(const Vec2& cellSize)
+	: m_cellSize(cellSize)
+{
+
+}
+
+long long SpatialHash::key(int cx, int cy) const
+{
+	return (long long)(((unsigned long long)(unsigned int)cx << 32) | (unsigned int)cy);
+}
+
+void SpatialHash::cellRange(const Vec2& pos, const Vec2& halfSize, int& minX, int& minY, int& maxX, int& maxY) const
+{
+	// a box whose edge lies exactly on a cell border does not enter the next cell
+	minX = (int)std::floor((pos.x - halfSize.x) / m_cellSize.x);
+	minY = (int)std::floor((pos.y - halfSize.y) / m_cellSize.y);
+	maxX = (int)std::ceil((pos.x + halfSize.x) / m_cellSize.x) - 1;
+	maxY = (int)std::ceil((pos.y + halfSize.y) / m_cellSize.y) - 1;
+}
+
+void SpatialHash::clear()
+{
+	m_cells.clear();
+}
+
+void SpatialHash::insert(const Entity& entity)
+{
+	// entities without a box (decorations) or on no layer never enter the pair set
+	if (!entity.hasComponent<CBoundingBox>() || entity.getComponent<CBoundingBox>().layer == CollisionLayer::None)
+	{
+		return;
+	}
+
+	auto& box = entity.getComponent<CBoundingBox>();
+	insert(entity, entity.getComponent<CTransform>().pos, box.halfSize, box.layer);
+}
+
+void SpatialHash::remove(const Entity& entity)
+{
+	if (!entity.hasComponent<CBoundingBox>())
+	{
+		return;
+	}
+
+	remove(entity, entity.getComponent<CTransform>().pos, entity.getComponent<CBoundingBox>().halfSize);
+}
+
+void SpatialHash::insert(const Entity& entity, const Vec2& pos, const Vec2& halfSize, unsigned layer)
+{
+	int minX, minY, maxX, maxY;
+	cellRange(pos, halfSize, minX, minY, maxX, maxY);
+
+	for (int cx = minX; cx <= maxX; cx++)
+	{
+		for (int cy = minY; cy <= maxY; cy++)
+		{
+			m_cells[key(cx, cy)].push_back({ entity, layer });
+		}
+	}
+}
+
+void SpatialHash::remove(const Entity& entity, const Vec2& pos, const Vec2& halfSize)
+{
+	int minX, minY, maxX, maxY;
+	cellRange(pos, halfSize, minX, minY, maxX, maxY);
+
+	for (int cx = minX; cx <= maxX; cx++)
+	{
+		for (int cy = minY; cy <= maxY; cy++)
+		{
+			auto cell = m_cells.find(key(cx, cy));
+			if (cell == m_cells.end()) { continue; }
+
+			auto& vec = cell->second;
+			vec.erase(std::remove_if(vec.begin(), vec.end(),
+				[&](const Entry& entry) { return entry.entity == entity; }), vec.end());
+			if (vec.empty()) { m_cells.erase(cell); }
+		}
+	}
+}
+
+void SpatialHash::query(const Vec2& pos, const Vec2& halfSize, unsigned mask, EntityVec& out) const
+{
+	out.clear();
+
+	int minX, minY, maxX, maxY;
+	cellRange(pos, halfSize, minX, minY, maxX, maxY);
+
+	for (int cx = minX; cx <= maxX; cx++)
+	{
+		for (int cy = minY; cy <= maxY; cy++)
+		{
+			auto cell = m_cells.find(key(cx, cy));
+			if (cell == m_cells.end()) { continue; }
+
+			for (auto& entry : cell->second)
+			{
+				if ((entry.layer & mask) && entry.entity.isActive())
+				{
+					out.push_back(entry.entity);
+				}
+			}
+		}
+	}
+
+	// large entities live in several cells, keep each one once and in creation order
+	std::sort(out.begin(), out.end(),
+		[](const Entity& a, const Entity& b) { return a.id() < b.id(); });
+	out.erase(std::unique(out.begin(), out.end()), out.end());
+}
\ No newline at end of file
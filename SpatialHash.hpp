@@ -0,0 +1,41 @@
+#pragma once
+
+#include "EntityManager.hpp"
+
+#include <unordered_map>
+
+// uniform grid index over entity boxes, used as the collision broadphase and for render culling
+// every entity is stored in each cell its box covers, so a query only has to
+// visit the cells covered by the query box to find all potential overlaps
+class SpatialHash
+{
+	struct Entry
+	{
+		Entity		entity;
+		unsigned	layer;
+	};
+
+	Vec2											m_cellSize = { 64, 64 };
+	std::unordered_map<long long, std::vector<Entry>>	m_cells;
+
+	long long key(int cx, int cy) const;
+	void cellRange(const Vec2& pos, const Vec2& halfSize, int& minX, int& minY, int& maxX, int& maxY) const;
+
+public:
+
+	SpatialHash();
+	SpatialHash(const Vec2& cellSize);
+
+	void clear();
+
+	// insert / remove by the entity's bounding box and collision layer
+	void insert(const Entity& entity);
+	void remove(const Entity& entity);
+
+	// insert / remove by an explicit box, for entities indexed by something other than their bounding box
+	void insert(const Entity& entity, const Vec2& pos, const Vec2& halfSize, unsigned layer);
+	void remove(const Entity& entity, const Vec2& pos, const Vec2& halfSize);
+
+	// fills out with every active entity whose box touches the query box and whose layer is in mask
+	void query(const Vec2& pos, const Vec2& halfSize, unsigned mask, EntityVec& out) const;
+};
\ No newline at end of file
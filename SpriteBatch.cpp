@@ -0,0 +1,97 @@
+#include "SpriteBatch.hpp"
+
+#include <cmath>
+
+SpriteBatch::SpriteBatch()
+{
+
+}
+
+SpriteBatch::Batch& SpriteBatch::batchFor(const sf::Texture* texture)
+{
+	for (size_t i = 0; i < m_usedBatches; i++)
+	{
+		if (m_batches[i].texture == texture) { return m_batches[i]; }
+	}
+
+	if (m_usedBatches == m_batches.size())
+	{
+		m_batches.emplace_back();
+	}
+
+	Batch& batch = m_batches[m_usedBatches++];
+	batch.texture = texture;
+	return batch;
+}
+
+void SpriteBatch::begin()
+{
+	// clearing keeps each vertex array's capacity, so steady-state frames don't allocate
+	for (auto& batch : m_batches)
+	{
+		batch.vertices.clear();
+	}
+
+	m_usedBatches = 0;
+	m_sprites = 0;
+}
+
+void SpriteBatch::draw(const sf::Sprite& sprite, const Vec2& pos, float angle)
+{
+	// same transform sf::Transformable would build, without touching the sprite
+	sf::Transform transform;
+	transform.translate(pos.x, pos.y);
+	if (angle != 0) { transform.rotate(angle); }
+	transform.scale(sprite.getScale().x, sprite.getScale().y);
+	transform.translate(-sprite.getOrigin().x, -sprite.getOrigin().y);
+
+	const sf::IntRect& rect = sprite.getTextureRect();
+	const float w = (float)std::abs(rect.width);
+	const float h = (float)std::abs(rect.height);
+	const float left = (float)rect.left;
+	const float right = left + rect.width;
+	const float top = (float)rect.top;
+	const float bottom = top + rect.height;
+
+	sf::Vertex quad[4] =
+	{
+		sf::Vertex(transform.transformPoint(0, 0), sprite.getColor(), sf::Vector2f(left, top)),
+		sf::Vertex(transform.transformPoint(w, 0), sprite.getColor(), sf::Vector2f(right, top)),
+		sf::Vertex(transform.transformPoint(w, h), sprite.getColor(), sf::Vector2f(right, bottom)),
+		sf::Vertex(transform.transformPoint(0, h), sprite.getColor(), sf::Vector2f(left, bottom))
+	};
+
+	// two triangles per sprite
+	sf::VertexArray& vertices = batchFor(sprite.getTexture()).vertices;
+	vertices.append(quad[0]);
+	vertices.append(quad[1]);
+	vertices.append(quad[2]);
+	vertices.append(quad[0]);
+	vertices.append(quad[2]);
+	vertices.append(quad[3]);
+
+	m_sprites++;
+}
+
+void SpriteBatch::end(sf::RenderTarget& target)
+{
+	m_drawCalls = 0;
+
+	for (size_t i = 0; i < m_usedBatches; i++)
+	{
+		if (m_batches[i].vertices.getVertexCount() == 0) { continue; }
+
+		target.draw(m_batches[i].vertices, sf::RenderStates(m_batches[i].texture));
+		m_drawCalls++;
+	}
+}
+
+size_t SpriteBatch::spriteCount() const
+{
+	return m_sprites;
+}
+
+size_t SpriteBatch::drawCalls() const
+{
+	return m_drawCalls;
+}
\ No newline at end of file
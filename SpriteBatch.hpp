@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Vec2.hpp"
+
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+// collects sprites into one vertex array per texture and draws each array
+// with a single draw call, so a whole level costs a handful of draws instead
+// of one per entity; the vertex arrays persist between frames to reuse memory
+// batches are flushed in the order their texture was first seen this frame
+class SpriteBatch
+{
+	struct Batch
+	{
+		const sf::Texture*	texture = nullptr;
+		sf::VertexArray		vertices { sf::Triangles };
+	};
+
+	std::vector<Batch>	m_batches;
+	size_t				m_usedBatches	= 0;
+	size_t				m_sprites		= 0;
+	size_t				m_drawCalls		= 0;
+
+	Batch& batchFor(const sf::Texture* texture);
+
+public:
+
+	SpriteBatch();
+
+	void begin();
+
+	// queues the sprite as if its origin were placed at pos and rotated by angle,
+	// the sprite itself is not modified
+	void draw(const sf::Sprite& sprite, const Vec2& pos, float angle = 0);
+
+	void end(sf::RenderTarget& target);
+
+	size_t spriteCount() const;
+	size_t drawCalls() const;	// draw calls issued by the last end()
+};
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "StateGraph.hpp"
+#include "Components.hpp"
+
+#include <cassert>
+
+StateGraph::StateGraph()
+{
+
+}
+
+StateGraph::StateGraph(size_t stateCount, size_t eventCount)
+	: m_stateCount(stateCount)
+	, m_eventCount(eventCount)
+	, m_transitions(stateCount * eventCount)
+	, m_animations(stateCount, nullptr)
+{
+	for (size_t state = 0; state < stateCount; state++)
+	{
+		for (size_t event = 0; event < eventCount; event++)
+		{
+			m_transitions[state * m_eventCount + event] = state;
+		}
+	}
+}
+
+void StateGraph::addTransition(size_t from, size_t event, size_t to)
+{
+	assert(from < m_stateCount && to < m_stateCount && event < m_eventCount);
+	m_transitions[from * m_eventCount + event] = to;
+}
+
+void StateGraph::setAnimation(size_t state, const Animation& animation)
+{
+	m_animations[state] = &animation;
+}
+
+size_t StateGraph::next(size_t state, size_t event) const
+{
+	return m_transitions[state * m_eventCount + event];
+}
+
+const Animation& StateGraph::animation(size_t state) const
+{
+	assert(m_animations[state] && "state has no animation");
+	return *m_animations[state];
+}
+
+void StateGraph::trigger(CState& state, size_t event) const
+{
+	size_t next = this->next(state.state, event);
+	if (next != state.state)
+	{
+		state.state = next;
+		state.changed = true;
+	}
+}
\ No newline at end of file
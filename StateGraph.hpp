@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Animation.hpp"
+
+#include <vector>
+
+class CState;
+
+// a table-driven finite state machine shared by every entity of one kind
+// states and events are small integers (normally enums owned by the scene),
+// the transition table is indexed [state][event], and each state's animation
+// is resolved once when the graph is built so switching costs no string work
+class StateGraph
+{
+	size_t							m_stateCount = 0;
+	size_t							m_eventCount = 0;
+	std::vector<size_t>				m_transitions;	// m_transitions[state * m_eventCount + event]
+	std::vector<const Animation*>	m_animations;	// animation shown in each state
+
+public:
+
+	StateGraph();
+	StateGraph(size_t stateCount, size_t eventCount);
+
+	// events without a transition leave the state unchanged
+	void addTransition(size_t from, size_t event, size_t to);
+	void setAnimation(size_t state, const Animation& animation);
+
+	size_t next(size_t state, size_t event) const;
+	const Animation& animation(size_t state) const;
+
+	// feeds an event to an entity's state, flagging it changed if it moved
+	void trigger(CState& state, size_t event) const;
+};
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "SystemScheduler.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+
+SystemScheduler::SystemScheduler()
+{
+
+}
+
+void SystemScheduler::add(const std::string& name, AccessMask reads, AccessMask writes, std::function<void()> run)
+{
+	System system;
+	system.name = name;
+	system.reads = reads;
+	system.writes = writes;
+	system.run = std::move(run);
+	system.profileScope = Profiler::instance().registerScope(system.name.c_str());
+
+	// the system goes into the batch after the last one holding a system it conflicts with
+	size_t batch = 0;
+	for (size_t b = 0; b < m_batches.size(); b++)
+	{
+		for (size_t i : m_batches[b])
+		{
+			const System& other = m_systems[i];
+			if ((other.writes & (system.reads | system.writes)) || (system.writes & other.reads))
+			{
+				batch = b + 1;
+			}
+		}
+	}
+
+	if (batch == m_batches.size()) { m_batches.emplace_back(); }
+	m_batches[batch].push_back(m_systems.size());
+	m_systems.push_back(std::move(system));
+}
+
+void SystemScheduler::run(const System& system) const
+{
+#if MARIO_PROFILE
+	ProfileScope scope(system.profileScope);
+#endif
+	system.run();
+}
+
+void SystemScheduler::run(JobSystem& jobs) const
+{
+	for (auto& batch : m_batches)
+	{
+		// the first system of a batch runs on this thread while the others are queued
+		JobSystem::Group group;
+		for (size_t i = 1; i < batch.size(); i++)
+		{
+			const System& system = m_systems[batch[i]];
+			jobs.submit(group, [this, &system]() { run(system); });
+		}
+
+		run(m_systems[batch[0]]);
+		jobs.wait(group);
+	}
+}
+
+std::string SystemScheduler::describe() const
+{
+	std::string description;
+	for (auto& batch : m_batches)
+	{
+		if (!description.empty()) { description += ", "; }
+		for (size_t i = 0; i < batch.size(); i++)
+		{
+			description += (i > 0 ? " + " : "") + m_systems[batch[i]].name;
+		}
+	}
+	return description;
+}
\ No newline at end of file
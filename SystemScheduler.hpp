@@ -0,0 +1,61 @@
+#pragma once
+
+#include "ComponentStore.hpp"
+#include "JobSystem.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// what a system touches: one bit per component type, plus the entity state that is not a component
+typedef std::uint32_t AccessMask;
+
+namespace Access
+{
+	enum : AccessMask
+	{
+		Lifetime	= 1u << 29,		// destroying entities and testing isActive()
+		Structure	= 1u << 30,		// adding entities, the entity vectors, and anything that grows the component arrays
+		World		= 1u << 31,		// the scene's own indices: tilemap, broadphase, render index, level chunks
+		All			= ~0u
+	};
+
+	template <typename... Ts>
+	AccessMask components()
+	{
+		return (AccessMask(0) | ... | (AccessMask(1) << ComponentIndex<Ts, ComponentTuple>::value));
+	}
+}
+
+static_assert(std::tuple_size<ComponentTuple>::value < 29, "component bits would overlap the Access bits");
+
+// runs a fixed list of systems once per step, in the order they were added as far as anyone can tell:
+// a system only runs concurrently with the systems before it that it does not conflict with,
+// two systems conflict if one writes something the other reads or writes
+class SystemScheduler
+{
+	struct System
+	{
+		std::string				name;
+		AccessMask				reads = 0;
+		AccessMask				writes = 0;
+		std::function<void()>	run;
+		std::uint16_t			profileScope = 0;
+	};
+
+	std::vector<System>					m_systems;
+	std::vector<std::vector<size_t>>	m_batches;		// systems that run together, one batch after another
+
+	void run(const System& system) const;
+
+public:
+
+	SystemScheduler();
+
+	void add(const std::string& name, AccessMask reads, AccessMask writes, std::function<void()> run);
+	void run(JobSystem& jobs) const;
+
+	// the batches as "a + b, c, ...", for logging the schedule
+	std::string describe() const;
+};
\ No newline at end of file
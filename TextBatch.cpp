@@ -0,0 +1,132 @@
+#include "TextBatch.hpp"
+
+TextBatch::TextBatch()
+{
+
+}
+
+TextBatch::TextBatch(const sf::Font& font, unsigned characterSize)
+	: m_font(&font)
+	, m_characterSize(characterSize)
+{
+
+}
+
+TextBatch::Slot& TextBatch::slot(size_t index)
+{
+	if (index >= m_slots.size()) { m_slots.resize(index + 1); }
+	return m_slots[index];
+}
+
+void TextBatch::begin()
+{
+	for (auto& s : m_slots)
+	{
+		s.wasUsed = s.used;
+		s.used = false;
+	}
+	m_layouts = 0;
+}
+
+void TextBatch::set(size_t index, const std::string& text, const sf::Vector2f& position, const sf::Color& color)
+{
+	Slot& s = slot(index);
+	s.used = true;
+
+	if (s.valid && s.text == text && s.position == position && s.color == color) { return; }
+
+	s.text = text;
+	s.position = position;
+	s.color = color;
+	layout(s);
+}
+
+bool TextBatch::reuse(size_t index, const sf::Vector2f& position)
+{
+	Slot& s = slot(index);
+	if (!s.valid || s.position != position) { return false; }
+
+	s.used = true;
+	return true;
+}
+
+void TextBatch::layout(Slot& s)
+{
+	// the same placement sf::Text uses: the first line's baseline sits one character size below the position
+	s.quads.clear();
+	s.valid = true;
+	m_dirty = true;
+	m_layouts++;
+	if (!m_font) { return; }
+
+	float x = 0;
+	float y = (float)m_characterSize;
+	sf::Uint32 previous = 0;
+
+	for (unsigned char c : s.text)
+	{
+		sf::Uint32 current = c;
+		x += m_font->getKerning(previous, current, m_characterSize);
+		previous = current;
+
+		if (current == '\n')
+		{
+			x = 0;
+			y += m_font->getLineSpacing(m_characterSize);
+			continue;
+		}
+
+		const sf::Glyph& glyph = m_font->getGlyph(current, m_characterSize, false);
+		if (current != ' ' && current != '\t')
+		{
+			float left = s.position.x + x + glyph.bounds.left;
+			float top = s.position.y + y + glyph.bounds.top;
+			float right = left + glyph.bounds.width;
+			float bottom = top + glyph.bounds.height;
+
+			float u1 = (float)glyph.textureRect.left;
+			float v1 = (float)glyph.textureRect.top;
+			float u2 = (float)(glyph.textureRect.left + glyph.textureRect.width);
+			float v2 = (float)(glyph.textureRect.top + glyph.textureRect.height);
+
+			s.quads.push_back(sf::Vertex(sf::Vector2f(left, top), s.color, sf::Vector2f(u1, v1)));
+			s.quads.push_back(sf::Vertex(sf::Vector2f(right, top), s.color, sf::Vector2f(u2, v1)));
+			s.quads.push_back(sf::Vertex(sf::Vector2f(left, bottom), s.color, sf::Vector2f(u1, v2)));
+			s.quads.push_back(sf::Vertex(sf::Vector2f(left, bottom), s.color, sf::Vector2f(u1, v2)));
+			s.quads.push_back(sf::Vertex(sf::Vector2f(right, top), s.color, sf::Vector2f(u2, v1)));
+			s.quads.push_back(sf::Vertex(sf::Vector2f(right, bottom), s.color, sf::Vector2f(u2, v2)));
+		}
+
+		x += glyph.advance;
+	}
+}
+
+void TextBatch::draw(sf::RenderTarget& target)
+{
+	// the combined array is only rebuilt when a slot changed or started / stopped being drawn
+	for (auto& s : m_slots)
+	{
+		if (s.used != s.wasUsed) { m_dirty = true; }
+	}
+
+	if (m_dirty)
+	{
+		m_vertices.clear();
+		for (auto& s : m_slots)
+		{
+			if (!s.used) { continue; }
+			for (auto& v : s.quads) { m_vertices.append(v); }
+		}
+		m_dirty = false;
+	}
+
+	if (m_font && m_vertices.getVertexCount() > 0)
+	{
+		target.draw(m_vertices, sf::RenderStates(&m_font->getTexture(m_characterSize)));
+	}
+}
+
+size_t TextBatch::layoutCount() const
+{
+	return m_layouts;
+}
\ No newline at end of file
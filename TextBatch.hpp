@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+// draws many strings of one font and character size with a single draw call
+// each string lives in a numbered slot and keeps its laid-out glyph quads between frames,
+// so a slot is only laid out again when its string, position or color changes
+// slots that are not set or reused since the last begin() are not drawn
+class TextBatch
+{
+	struct Slot
+	{
+		std::string					text;
+		sf::Vector2f				position;
+		sf::Color					color;
+		std::vector<sf::Vertex>		quads;				// two triangles per visible glyph
+		bool						valid	= false;
+		bool						used	= false;
+		bool						wasUsed	= false;
+	};
+
+	const sf::Font*		m_font			= nullptr;
+	unsigned			m_characterSize	= 30;
+	std::vector<Slot>	m_slots;
+	sf::VertexArray		m_vertices { sf::Triangles };	// the quads of every used slot
+	bool				m_dirty			= true;
+	size_t				m_layouts		= 0;
+
+	Slot& slot(size_t index);
+	void layout(Slot& slot);
+
+public:
+
+	TextBatch();
+	TextBatch(const sf::Font& font, unsigned characterSize);
+
+	void begin();
+
+	void set(size_t index, const std::string& text, const sf::Vector2f& position, const sf::Color& color = sf::Color::White);
+
+	// keeps drawing the slot if it already holds text at this position, so callers whose string
+	// only depends on the position can skip building it; returns false if the slot has to be set
+	bool reuse(size_t index, const sf::Vector2f& position);
+
+	void draw(sf::RenderTarget& target);
+
+	size_t layoutCount() const;		// slots laid out since the last begin()
+};
\ No newline at end of file
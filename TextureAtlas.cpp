@@ -0,0 +1,165 @@
+#include "TextureAtlas.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	// repeats the outermost pixels of rect into the padding around it, so a filtered sample at the
+	// edge of a sprite blends with the sprite's own border, the same as clamping a texture to its edge
+	void extrude(sf::Image& page, const sf::IntRect& rect, int padding)
+	{
+		if (rect.width <= 0 || rect.height <= 0) { return; }
+
+		const int right = rect.left + rect.width - 1, bottom = rect.top + rect.height - 1;
+		for (int y = rect.top - padding; y <= bottom + padding; y++)
+		{
+			for (int x = rect.left - padding; x <= right + padding; x++)
+			{
+				if (x >= rect.left && x <= right && y >= rect.top && y <= bottom) { continue; }
+				page.setPixel(x, y, page.getPixel(std::clamp(x, rect.left, right), std::clamp(y, rect.top, bottom)));
+			}
+		}
+	}
+}
+
+TextureAtlas::TextureAtlas()
+{
+
+}
+
+TextureAtlas::TextureAtlas(unsigned pageSize, unsigned padding)
+	: m_pageSize(pageSize)
+	, m_padding(padding)
+{
+
+}
+
+void TextureAtlas::add(const std::string& name, const sf::Image& image)
+{
+	m_images.emplace_back(name, image);
+}
+
+void TextureAtlas::build(bool createTextures, bool smooth, std::vector<sf::Image>* pageImages)
+{
+	// place the tallest images first so each shelf wastes as little height as possible
+	std::vector<size_t> order(m_images.size());
+	for (size_t i = 0; i < order.size(); i++) { order[i] = i; }
+	std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b)
+	{
+		return m_images[a].second.getSize().y > m_images[b].second.getSize().y;
+	});
+
+	std::vector<sf::Vector2u> pageSizes;
+	unsigned x = 0, y = 0, shelfHeight = 0;
+
+	for (size_t i : order)
+	{
+		const sf::Vector2u size = m_images[i].second.getSize();
+		const unsigned w = size.x + 2 * m_padding;
+		const unsigned h = size.y + 2 * m_padding;
+
+		// move to a new shelf when this row is full, and to a new page when the page is full
+		if (pageSizes.empty() || x + w > m_pageSize)
+		{
+			y += shelfHeight;
+			x = 0;
+			shelfHeight = 0;
+		}
+		if (pageSizes.empty() || y + h > m_pageSize)
+		{
+			pageSizes.push_back(sf::Vector2u(0, 0));
+			x = y = shelfHeight = 0;
+		}
+
+		m_regions[m_images[i].first] = { pageSizes.size() - 1, sf::IntRect(x + m_padding, y + m_padding, size.x, size.y) };
+
+		// pages only grow as large as their contents
+		pageSizes.back().x = std::max(pageSizes.back().x, x + w);
+		pageSizes.back().y = std::max(pageSizes.back().y, y + h);
+		x += w;
+		shelfHeight = std::max(shelfHeight, h);
+	}
+
+	m_pageCount = pageSizes.size();
+
+	if (createTextures || pageImages)
+	{
+		// compose each page on the CPU and upload it once
+		std::vector<sf::Image> images(m_pageCount);
+		for (size_t p = 0; p < m_pageCount; p++)
+		{
+			images[p].create(pageSizes[p].x, pageSizes[p].y, sf::Color(0, 0, 0, 0));
+		}
+
+		for (auto& [name, image] : m_images)
+		{
+			const Region& r = m_regions[name];
+			images[r.page].copy(image, r.rect.left, r.rect.top);
+			extrude(images[r.page], r.rect, (int)m_padding);
+		}
+
+		if (createTextures)
+		{
+			// pages are created up front so the vector never moves a texture sprites point to
+			m_pages = std::vector<sf::Texture>(m_pageCount);
+			for (size_t p = 0; p < m_pageCount; p++)
+			{
+				m_pages[p].loadFromImage(images[p]);
+				m_pages[p].setSmooth(smooth);
+			}
+		}
+
+		if (pageImages) { *pageImages = std::move(images); }
+	}
+
+	m_images.clear();
+}
+
+void TextureAtlas::addRegion(const std::string& name, const Region& region)
+{
+	m_regions[name] = region;
+}
+
+void TextureAtlas::setPages(const std::vector<sf::Vector2u>& sizes, const std::vector<const sf::Uint8*>& pixels, bool createTextures, bool smooth)
+{
+	m_pageCount = sizes.size();
+
+	if (createTextures)
+	{
+		m_pages = std::vector<sf::Texture>(m_pageCount);
+		for (size_t p = 0; p < m_pageCount; p++)
+		{
+			m_pages[p].create(sizes[p].x, sizes[p].y);
+			m_pages[p].update(pixels[p]);
+			m_pages[p].setSmooth(smooth);
+		}
+	}
+}
+
+bool TextureAtlas::hasRegion(const std::string& name) const
+{
+	return m_regions.find(name) != m_regions.end();
+}
+
+const TextureAtlas::Region& TextureAtlas::region(const std::string& name) const
+{
+	assert(hasRegion(name));
+	return m_regions.at(name);
+}
+
+const std::map<std::string, TextureAtlas::Region>& TextureAtlas::regions() const
+{
+	return m_regions;
+}
+
+const sf::Texture& TextureAtlas::page(size_t index) const
+{
+	assert(index < m_pages.size());
+	return m_pages[index];
+}
+
+size_t TextureAtlas::pageCount() const
+{
+	return m_pageCount;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+// packs many small images into a few large texture pages at load time
+// so sprites from different assets can share a texture (and a draw call)
+// images are placed with a simple shelf packer, tallest first
+class TextureAtlas
+{
+public:
+
+	struct Region
+	{
+		size_t		page = 0;	// index of the page texture holding the image
+		sf::IntRect	rect;		// pixel rectangle of the image inside that page
+	};
+
+private:
+
+	std::vector<std::pair<std::string, sf::Image>>	m_images;	// added but not yet packed
+	std::map<std::string, Region>					m_regions;
+	std::vector<sf::Texture>						m_pages;
+	unsigned										m_pageSize	= 2048;
+	unsigned										m_padding	= 2;	// border around each image, a copy of its edge pixels so filtering never blends in transparency
+	size_t											m_pageCount	= 0;
+
+public:
+
+	TextureAtlas();
+	TextureAtlas(unsigned pageSize, unsigned padding);
+
+	void add(const std::string& name, const sf::Image& image);
+
+	// packs every added image into pages, the page textures are only created
+	// (and uploaded to the GPU) when createTextures is set
+	// the composed page images are also returned through pageImages when it is given
+	void build(bool createTextures, bool smooth, std::vector<sf::Image>* pageImages = nullptr);
+
+	// restores an atlas packed earlier (an asset pack) from its regions and raw RGBA page pixels
+	void addRegion(const std::string& name, const Region& region);
+	void setPages(const std::vector<sf::Vector2u>& sizes, const std::vector<const sf::Uint8*>& pixels, bool createTextures, bool smooth);
+
+	bool hasRegion(const std::string& name) const;
+	const Region& region(const std::string& name) const;
+	const std::map<std::string, Region>& regions() const;
+	const sf::Texture& page(size_t index) const;
+	size_t pageCount() const;
+};
\ No newline at end of file
@@ -0,0 +1,274 @@
+#include "TileMap.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+TileMap::TileMap()
+{
+
+}
+
+TileMap::TileMap(const Vec2& cellSize, float worldHeight)
+	: m_cellSize(cellSize)
+	, m_worldHeight(worldHeight)
+{
+
+}
+
+long long TileMap::key(int cx, int cy) const
+{
+	return (long long)(((unsigned long long)(unsigned int)cx << 32) | (unsigned int)cy);
+}
+
+int TileMap::chunkCoord(int g) const
+{
+	// floor division so negative grid positions land in the correct chunk
+	return (g >= 0) ? g / ChunkSize : (g - ChunkSize + 1) / ChunkSize;
+}
+
+void TileMap::cellRange(const Vec2& pos, const Vec2& halfSize, int& minX, int& minY, int& maxX, int& maxY) const
+{
+	// pixel y grows downward while grid y grows upward from the bottom of the world
+	minX = (int)std::floor((pos.x - halfSize.x) / m_cellSize.x);
+	maxX = (int)std::ceil((pos.x + halfSize.x) / m_cellSize.x) - 1;
+	minY = (int)std::floor((m_worldHeight - (pos.y + halfSize.y)) / m_cellSize.y);
+	maxY = (int)std::ceil((m_worldHeight - (pos.y - halfSize.y)) / m_cellSize.y) - 1;
+}
+
+TileMap::TileID TileMap::registerTile(const Animation& animation, const Vec2& scale)
+{
+	for (size_t i = 0; i < m_palette.size(); i++)
+	{
+		if (m_palette[i].getName() == animation.getName())
+		{
+			return (TileID)(i + 1);
+		}
+	}
+
+	m_palette.push_back(animation);
+	m_palette.back().getSprite().setScale(scale.x, scale.y);
+	return (TileID)m_palette.size();
+}
+
+void TileMap::set(int gx, int gy, TileID id)
+{
+	Chunk& chunk = m_chunks[key(chunkCoord(gx), chunkCoord(gy))];
+	TileID& cell = chunk.cells[(gy - chunkCoord(gy) * ChunkSize) * ChunkSize + (gx - chunkCoord(gx) * ChunkSize)];
+
+	if (cell == 0 && id != 0) { chunk.count++; m_tileCount++; }
+	if (cell != 0 && id == 0) { chunk.count--; m_tileCount--; }
+	cell = id;
+
+	if (!chunk.dirty)
+	{
+		chunk.dirty = true;
+		m_dirtyChunks.push_back(std::make_pair(chunkCoord(gx), chunkCoord(gy)));
+	}
+}
+
+TileMap::TileID TileMap::get(int gx, int gy) const
+{
+	auto chunk = m_chunks.find(key(chunkCoord(gx), chunkCoord(gy)));
+	if (chunk == m_chunks.end()) { return 0; }
+
+	return chunk->second.cells[(gy - chunkCoord(gy) * ChunkSize) * ChunkSize + (gx - chunkCoord(gx) * ChunkSize)];
+}
+
+Vec2 TileMap::cellCenter(int gx, int gy) const
+{
+	return Vec2(gx * m_cellSize.x + m_cellSize.x / 2, m_worldHeight - gy * m_cellSize.y - m_cellSize.y / 2);
+}
+
+Vec2 TileMap::cellHalfSize() const
+{
+	return m_cellSize / 2;
+}
+
+size_t TileMap::tileCount() const
+{
+	return m_tileCount;
+}
+
+size_t TileMap::colliderCount() const
+{
+	return m_colliderCount;
+}
+
+bool TileMap::hasTiles(int cx, int cy) const
+{
+	auto chunk = m_chunks.find(key(cx, cy));
+	return chunk != m_chunks.end() && chunk->second.count > 0;
+}
+
+void TileMap::mergeColliders()
+{
+	for (auto& [cx, cy] : m_dirtyChunks)
+	{
+		mergeChunk(cx, cy, m_chunks[key(cx, cy)]);
+	}
+
+	// colliders can span the neighbours of a changed chunk, so the whole row of chunks with tiles around it is joined again
+	for (auto& [cx, cy] : m_dirtyChunks)
+	{
+		if (!m_chunks[key(cx, cy)].dirty) { continue; }
+
+		int firstCx = cx, lastCx = cx;
+		while (hasTiles(firstCx - 1, cy)) { firstCx--; }
+		while (hasTiles(lastCx + 1, cy)) { lastCx++; }
+		joinChunks(cy, firstCx, lastCx);
+	}
+	m_dirtyChunks.clear();
+}
+
+void TileMap::mergeChunk(int cx, int cy, Chunk& chunk)
+{
+	chunk.pieces.clear();
+
+	std::array<bool, ChunkSize * ChunkSize> merged = {};
+	auto isFree = [&](int x, int y) { return chunk.cells[y * ChunkSize + x] != 0 && !merged[y * ChunkSize + x]; };
+
+	for (int y = 0; y < ChunkSize; y++)
+	{
+		for (int x = 0; x < ChunkSize; x++)
+		{
+			if (!isFree(x, y)) { continue; }
+
+			// take the longest run of cells along the row, then grow it upward while the whole run is solid
+			int w = 1, h = 1;
+			while (x + w < ChunkSize && isFree(x + w, y)) { w++; }
+			while (y + h < ChunkSize)
+			{
+				bool rowFree = true;
+				for (int i = 0; i < w && rowFree; i++) { rowFree = isFree(x + i, y + h); }
+				if (!rowFree) { break; }
+				h++;
+			}
+
+			for (int j = 0; j < h; j++)
+			{
+				for (int i = 0; i < w; i++) { merged[(y + j) * ChunkSize + x + i] = true; }
+			}
+
+			chunk.pieces.push_back({ cx * ChunkSize + x, cy * ChunkSize + y, w, h });
+		}
+	}
+}
+
+void TileMap::joinChunks(int cy, int firstCx, int lastCx)
+{
+	for (int cx = firstCx; cx <= lastCx; cx++)
+	{
+		Chunk& chunk = m_chunks[key(cx, cy)];
+		m_colliderCount -= chunk.owned;
+		chunk.colliders.clear();
+		chunk.owned = 0;
+		chunk.dirty = false;
+	}
+
+	auto addCollider = [&](const Rect& rect)
+	{
+		Vec2 halfSize(rect.w * m_cellSize.x / 2, rect.h * m_cellSize.y / 2);
+		Box box = { Vec2(rect.x * m_cellSize.x + halfSize.x, m_worldHeight - rect.y * m_cellSize.y - halfSize.y), halfSize };
+		for (int cx = chunkCoord(rect.x); cx <= chunkCoord(rect.x + rect.w - 1); cx++)
+		{
+			m_chunks[key(cx, cy)].colliders.push_back(box);
+		}
+		m_chunks[key(chunkCoord(rect.x), cy)].owned++;
+		m_colliderCount++;
+	};
+
+	// pieces reaching the right edge of a chunk stay open, a piece of the next chunk
+	// starting at its left edge on exactly the same rows extends them
+	std::vector<Rect> open, stillOpen;
+	for (int cx = firstCx; cx <= lastCx; cx++)
+	{
+		stillOpen.clear();
+		for (Rect rect : m_chunks[key(cx, cy)].pieces)
+		{
+			if (rect.x == cx * ChunkSize)
+			{
+				auto joined = std::find_if(open.begin(), open.end(), [&](const Rect& o) { return o.y == rect.y && o.h == rect.h; });
+				if (joined != open.end())
+				{
+					rect = { joined->x, rect.y, joined->w + rect.w, rect.h };
+					open.erase(joined);
+				}
+			}
+
+			if (rect.x + rect.w == (cx + 1) * ChunkSize)	{ stillOpen.push_back(rect); }
+			else											{ addCollider(rect); }
+		}
+
+		for (auto& rect : open) { addCollider(rect); }
+		open.swap(stillOpen);
+	}
+
+	for (auto& rect : open) { addCollider(rect); }
+}
+
+void TileMap::query(const Vec2& pos, const Vec2& halfSize, std::vector<Box>& out) const
+{
+	out.clear();
+
+	int minX, minY, maxX, maxY;
+	cellRange(pos, halfSize, minX, minY, maxX, maxY);
+
+	const int firstCx = chunkCoord(minX);
+	for (int cx = firstCx; cx <= chunkCoord(maxX); cx++)
+	{
+		for (int cy = chunkCoord(minY); cy <= chunkCoord(maxY); cy++)
+		{
+			auto chunk = m_chunks.find(key(cx, cy));
+			if (chunk == m_chunks.end()) { continue; }
+
+			// a box only touching a collider's edge does not overlap it, same as a cell on the border of the range
+			for (auto& box : chunk->second.colliders)
+			{
+				// a collider held by several chunks is reported by the first of them inside the range
+				int startCx = chunkCoord((int)std::lround((box.pos.x - box.halfSize.x) / m_cellSize.x));
+				if (std::max(startCx, firstCx) != cx) { continue; }
+
+				if (std::abs(box.pos.x - pos.x) < box.halfSize.x + halfSize.x &&
+					std::abs(box.pos.y - pos.y) < box.halfSize.y + halfSize.y)
+				{
+					out.push_back(box);
+				}
+			}
+		}
+	}
+}
+
+size_t TileMap::render(SpriteBatch& batch, const sf::FloatRect& area) const
+{
+	size_t drawn = 0;
+	int minX, minY, maxX, maxY;
+	Vec2 halfSize(area.width / 2, area.height / 2);
+	cellRange(Vec2(area.left + halfSize.x, area.top + halfSize.y), halfSize, minX, minY, maxX, maxY);
+
+	for (int cx = chunkCoord(minX); cx <= chunkCoord(maxX); cx++)
+	{
+		for (int cy = chunkCoord(minY); cy <= chunkCoord(maxY); cy++)
+		{
+			auto chunk = m_chunks.find(key(cx, cy));
+			if (chunk == m_chunks.end() || chunk->second.count == 0) { continue; }
+
+			// only the cells of the chunk inside the view, a chunk can reach up to ChunkSize - 1 cells past each edge
+			int x0 = std::max(minX - cx * ChunkSize, 0), x1 = std::min(maxX - cx * ChunkSize, ChunkSize - 1);
+			int y0 = std::max(minY - cy * ChunkSize, 0), y1 = std::min(maxY - cy * ChunkSize, ChunkSize - 1);
+			for (int y = y0; y <= y1; y++)
+			{
+				for (int x = x0; x <= x1; x++)
+				{
+					TileID id = chunk->second.cells[y * ChunkSize + x];
+					if (id == 0) { continue; }
+
+					Vec2 center = cellCenter(cx * ChunkSize + x, cy * ChunkSize + y);
+					batch.draw(m_palette[id - 1].getSprite(), center);
+					drawn++;
+				}
+			}
+		}
+	}
+
+	return drawn;
+}
\ No newline at end of file
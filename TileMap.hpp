@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Animation.hpp"
+#include "SpriteBatch.hpp"
+
+#include <array>
+#include <vector>
+#include <unordered_map>
+
+// dense storage for static, solid, single-cell level tiles
+// each grid cell holds a small tile id into a palette of animations, and cells are
+// grouped into fixed-size chunks so empty regions of a level cost no memory at all
+// grid coordinates match the level file: x grows right, y grows up from the bottom
+class TileMap
+{
+public:
+
+	typedef unsigned short TileID;				// 0 is an empty cell
+	static const int ChunkSize = 16;			// chunks are ChunkSize x ChunkSize cells
+
+	// a solid pixel rectangle covering one or more cells
+	struct Box
+	{
+		Vec2	pos;
+		Vec2	halfSize;
+	};
+
+private:
+
+	// a rectangle of cells in grid coordinates
+	struct Rect
+	{
+		int		x, y, w, h;
+	};
+
+	struct Chunk
+	{
+		std::array<TileID, ChunkSize * ChunkSize>	cells = {};
+		size_t										count = 0;	// number of non-empty cells
+		std::vector<Rect>							pieces;		// the solid cells merged into rectangles inside the chunk
+		std::vector<Box>							colliders;	// pieces joined across chunk edges, held by every chunk they cover
+		size_t										owned = 0;	// colliders that begin in this chunk
+		bool										dirty = false;
+	};
+
+	Vec2								m_cellSize		= { 64, 64 };
+	float								m_worldHeight	= 768;
+	std::vector<Animation>				m_palette;				// animation for TileID i is m_palette[i - 1]
+	std::unordered_map<long long, Chunk> m_chunks;
+	size_t								m_tileCount		= 0;
+	size_t								m_colliderCount	= 0;
+	std::vector<std::pair<int, int>>	m_dirtyChunks;			// chunks whose colliders are out of date
+
+	long long key(int cx, int cy) const;
+	int chunkCoord(int g) const;
+	void cellRange(const Vec2& pos, const Vec2& halfSize, int& minX, int& minY, int& maxX, int& maxY) const;
+	bool hasTiles(int cx, int cy) const;
+	void mergeChunk(int cx, int cy, Chunk& chunk);
+	void joinChunks(int cy, int firstCx, int lastCx);
+
+public:
+
+	TileMap();
+	TileMap(const Vec2& cellSize, float worldHeight);
+
+	TileID registerTile(const Animation& animation, const Vec2& scale);
+
+	void set(int gx, int gy, TileID id);
+	TileID get(int gx, int gy) const;
+
+	Vec2 cellCenter(int gx, int gy) const;
+	Vec2 cellHalfSize() const;
+	size_t tileCount() const;
+	size_t colliderCount() const;
+
+	// merges the solid cells of every chunk changed by set into as few rectangles as it can
+	// (greedy inside a chunk), then joins rectangles of the same rows across neighbouring chunks,
+	// so a run of ground is one box with no seams; query returns these instead of single cells
+	void mergeColliders();
+
+	// fills out with every merged collider the given box touches
+	void query(const Vec2& pos, const Vec2& halfSize, std::vector<Box>& out) const;
+
+	// only the chunks intersecting the given pixel area are visited, returns the number of tiles drawn
+	size_t render(SpriteBatch& batch, const sf::FloatRect& area) const;
+};
\ No newline at end of file
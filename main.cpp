@@ -1,10 +1,258 @@
 #include <SFML/Graphics.hpp>
 #include "GameEngine.hpp"
+#include "Scene_Play.hpp"
+
+#include "Profiler.hpp"
+#include "LevelGenerator.hpp"
+#include "Benchmark.hpp"
+#include "Physics.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
 
 int main(int argc, char* argv[])
 {
+	std::vector<std::string> args(argv + 1, argv + argc);
+
+	// removes an option and its value from the arguments, returning the value or "" if it is not given
+	auto takeOption = [&](const std::string& option)
+	{
+		std::string value;
+		auto arg = std::find(args.begin(), args.end(), option);
+		if (arg != args.end() && arg + 1 != args.end())
+		{
+			value = *(arg + 1);
+			args.erase(arg, arg + 2);
+		}
+		return value;
+	};
+
+	// --profile <file> can be given with any mode, the recorded system timings are written when the run ends
+	// as a Chrome trace (chrome://tracing, Perfetto), or as CSV if the file ends in .csv
+	const std::string profilePath = takeOption("--profile");
+
+	// --threads <n> sets the number of worker threads the scenes' systems are spread over, 0 runs everything on the main thread
+	const std::string threads = takeOption("--threads");
+	auto setThreads = [&](GameEngine& game)
+	{
+		if (!threads.empty()) { game.jobs().setWorkerCount(std::stoul(threads)); }
+	};
+
+	// --record <file> saves the actions of a normal game session, to be run again with --replay
+	const std::string recordPath = takeOption("--record");
+
+	auto saveProfile = [&]()
+	{
+		if (profilePath.empty()) { return; }
+		if (!MARIO_PROFILE) { std::cerr << "Profiling was compiled out, " << profilePath << " is not written" << std::endl; return; }
+		if (!Profiler::instance().save(profilePath)) { std::cerr << "Could not write " << profilePath << std::endl; return; }
+		std::cout << "Wrote profile to " << profilePath << std::endl;
+	};
+
+	// headless simulation: mario --headless [level] [frames] [speed]
+	// runs the play scene with no window or GL context and reports the frame rate
+	// speed is the number of fixed simulation steps run per engine frame
+	if (args.size() >= 1 && args[0] == "--headless")
+	{
+		const std::string level = (args.size() >= 2) ? args[1] : "level1.txt";
+		const size_t frames = (args.size() >= 3) ? std::stoul(args[2]) : 10000;
+		const size_t speed = (args.size() >= 4) ? std::stoul(args[3]) : 1;
+
+		GameEngine g("assets.txt", true);
+		setThreads(g);
+		g.setSimulationSpeed(speed);
+		g.changeScene("PLAY", std::make_shared<Scene_Play>(&g, level));
+
+		sf::Clock clock;
+		g.run(frames);
+		const float seconds = clock.getElapsedTime().asSeconds();
+
+		std::cout << "Simulated " << frames * speed << " steps of " << level << " in " << seconds << "s ("
+			<< (seconds > 0 ? frames * speed / seconds : 0) << " steps/s)" << std::endl;
+		std::cout << g.summary() << std::endl;
+		saveProfile();
+		return 0;
+	}
+
+	// replay: mario --replay <recording>
+	// runs a session saved with --record headless, from the menu up to the step the recording ended at,
+	// and prints the final state so runs of different builds can be compared
+	if (args.size() >= 2 && args[0] == "--replay")
+	{
+		ActionLog log;
+		if (!log.load(args[1]))
+		{
+			std::cerr << "Could not load recording " << args[1] << std::endl;
+			return 1;
+		}
+
+		GameEngine g("assets.txt", true);
+		setThreads(g);
+
+		sf::Clock clock;
+		const size_t steps = g.replay(log);
+		const float seconds = clock.getElapsedTime().asSeconds();
+
+		std::cout << "Replayed " << log.size() << " actions over " << steps << " steps in " << seconds << "s ("
+			<< (seconds > 0 ? steps / seconds : 0) << " steps/s)" << std::endl;
+		std::cout << g.summary() << std::endl;
+		saveProfile();
+		return 0;
+	}
+
+	// level generator: mario --generate <output> [tiles] [density] [brick ratio] [question ratio] [decorations] [seed]
+	// writes a random level of about the given number of tiles, see LevelGenerator::Settings for the defaults
+	if (args.size() >= 2 && args[0] == "--generate")
+	{
+		LevelGenerator::Settings settings;
+		const size_t tiles = (args.size() >= 3) ? std::stoul(args[2]) : 10000;
+		if (args.size() >= 4) { settings.density = std::stof(args[3]); }
+		if (args.size() >= 5) { settings.brickRatio = std::stof(args[4]); }
+		if (args.size() >= 6) { settings.questionRatio = std::stof(args[5]); }
+		if (args.size() >= 7) { settings.decorations = std::stoul(args[6]); }
+		if (args.size() >= 8) { settings.seed = (unsigned)std::stoul(args[7]); }
+		settings.width = LevelGenerator::widthFor(tiles, settings.density);
+
+		const size_t written = LevelGenerator::write(args[1], settings);
+		if (written == 0)
+		{
+			std::cerr << "Could not write " << args[1] << std::endl;
+			return 1;
+		}
+
+		std::cout << "Generated " << args[1] << " with " << written << " tiles in " << settings.width << " columns" << std::endl;
+		return 0;
+	}
+
+	// benchmark: mario --benchmark [steps] [tiles...]
+	// generates levels of each size (1k to 1M tiles by default) and simulates them with scripted input
+	if (args.size() >= 1 && args[0] == "--benchmark")
+	{
+		const size_t steps = (args.size() >= 2) ? std::stoul(args[1]) : 1200;
+		std::vector<size_t> sizes = { 1000, 10000, 100000, 1000000 };
+		if (args.size() >= 3)
+		{
+			sizes.clear();
+			for (size_t i = 2; i < args.size(); i++) { sizes.push_back(std::stoul(args[i])); }
+		}
+
+		GameEngine g("assets.txt", true);
+		setThreads(g);
+
+		std::vector<std::pair<size_t, BenchmarkResult>> results;
+		for (size_t tiles : sizes)
+		{
+			LevelGenerator::Settings settings;
+			settings.width = LevelGenerator::widthFor(tiles, settings.density);
+			settings.decorations = tiles / 20;
+
+			const std::string level = (std::filesystem::temp_directory_path() / ("mario_bench_" + std::to_string(tiles) + ".txt")).string();
+			const size_t written = LevelGenerator::write(level, settings);
+			if (written == 0)
+			{
+				std::cerr << "Could not write " << level << std::endl;
+				return 1;
+			}
+
+			results.push_back({ written, runBenchmark(g, level, steps) });
+			std::filesystem::remove(level);
+		}
+
+		std::cout << std::endl << steps << " steps per level, times in ms" << std::endl;
+		std::cout << std::left << std::setw(10) << "tiles" << std::setw(10) << "load" << std::setw(12) << "steps/s"
+			<< std::setw(9) << "p50" << std::setw(9) << "p95" << std::setw(9) << "p99" << std::setw(9) << "max" << "peak RSS" << std::endl;
+		for (auto& [tiles, r] : results)
+		{
+			std::cout << std::left << std::fixed << std::setprecision(3) << std::setw(10) << tiles << std::setw(10) << r.loadMs
+				<< std::setprecision(0) << std::setw(12) << r.stepsPerSecond << std::setprecision(3) << std::setw(9) << r.p50Ms
+				<< std::setw(9) << r.p95Ms << std::setw(9) << r.p99Ms << std::setw(9) << r.maxMs << r.peakRssKb / 1024.0 << " MB" << std::endl;
+		}
+
+		saveProfile();
+		return 0;
+	}
+
+	// overlap microbenchmark: mario --benchmark-overlap [boxes...]
+	// times the batch overlap test against the per-pair one on the given numbers of boxes
+	if (args.size() >= 1 && args[0] == "--benchmark-overlap")
+	{
+		std::vector<size_t> sizes = { 8, 32, 256, 4096, 65536 };
+		if (args.size() >= 2)
+		{
+			sizes.clear();
+			for (size_t i = 1; i < args.size(); i++) { sizes.push_back(std::stoul(args[i])); }
+		}
+
+		std::cout << "batch kernel: " << Physics::OverlapKernel() << ", times in ns per box" << std::endl;
+		std::cout << std::left << std::setw(10) << "boxes" << std::setw(10) << "per-pair" << std::setw(10) << "batch"
+			<< std::setw(10) << "speedup" << "hits" << std::endl;
+		for (size_t boxes : sizes)
+		{
+			// about the same number of boxes tested at every size
+			const size_t repeats = std::max((size_t)1, (size_t)20000000 / std::max((size_t)1, boxes));
+			OverlapBenchmarkResult r = runOverlapBenchmark(boxes, repeats);
+			std::cout << std::left << std::fixed << std::setprecision(3) << std::setw(10) << boxes << std::setw(10) << r.pairNs
+				<< std::setw(10) << r.batchNs << std::setprecision(2) << std::setw(10) << (r.batchNs > 0 ? r.pairNs / r.batchNs : 0)
+				<< r.hits << (r.identical ? "" : "  MISMATCH") << std::endl;
+		}
+		return 0;
+	}
+
+	// level compiler: mario --compile [level] [output]
+	// writes a binary level that loads without parsing, it is picked up automatically next to the text level
+	if (args.size() >= 1 && args[0] == "--compile")
+	{
+		const std::string level = (args.size() >= 2) ? args[1] : "level1.txt";
+		const std::string output = (args.size() >= 3) ? args[2] : LevelStream::compiledPath(level);
+
+		GameEngine g("assets.txt", true);
+		Scene_Play scene(&g, level);
+		if (!scene.compileLevel(output))
+		{
+			std::cerr << "Could not compile " << level << " into " << output << std::endl;
+			return 1;
+		}
+
+		std::cout << "Compiled " << level << " into " << output << std::endl;
+		return 0;
+	}
+
+	// asset packer: mario --pack [assets] [output]
+	// decodes every image and font once into a pack that is picked up automatically next to the asset list
+	if (args.size() >= 1 && args[0] == "--pack")
+	{
+		const std::string assets = (args.size() >= 2) ? args[1] : "assets.txt";
+		const std::string output = (args.size() >= 3) ? args[2] : Assets::packPath(assets);
+
+		if (!Assets::buildPack(assets, output))
+		{
+			std::cerr << "Could not pack " << assets << " into " << output << std::endl;
+			return 1;
+		}
+
+		std::cout << "Packed " << assets << " into " << output << std::endl;
+		return 0;
+	}
+
 	GameEngine g("assets.txt");
+	setThreads(g);
+	if (!recordPath.empty()) { g.startRecording(); }
 	g.run();
+	saveProfile();
+
+	if (!recordPath.empty())
+	{
+		if (!g.saveRecording(recordPath))
+		{
+			std::cerr << "Could not write recording " << recordPath << std::endl;
+			return 1;
+		}
+		std::cout << "Recorded session to " << recordPath << ", final state " << g.summary() << std::endl;
+	}
 
 	return 0;
 }
\ No newline at end of file